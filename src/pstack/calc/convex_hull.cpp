@@ -0,0 +1,286 @@
+#include "pstack/calc/convex_hull.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace pstack::calc {
+
+namespace {
+
+using point = geo::vector3<double>;
+
+struct face {
+    std::array<std::uint32_t, 3> vertices; // Counter-clockwise seen from outside
+    std::array<std::uint32_t, 3> neighbours; // The face on the other side of the edge from `vertices[k]` to `vertices[k + 1]`
+    point normal;
+    double offset;
+    std::vector<std::uint32_t> outside; // The points above the face, which were given to it rather than any other face
+    bool alive;
+};
+
+class hull_builder {
+public:
+    explicit hull_builder(const mesh::coordinates& vertices) {
+        _points.reserve(vertices.size());
+        float scale = 0;
+        for (std::size_t i = 0; i != vertices.size(); ++i) {
+            _points.push_back({ vertices.x[i], vertices.y[i], vertices.z[i] });
+            scale = std::max({ scale, std::abs(vertices.x[i]), std::abs(vertices.y[i]), std::abs(vertices.z[i]) });
+        }
+        // The points only ever had the precision of a float, so anything closer to a face than that is taken to be on it
+        _tolerance = 8 * std::numeric_limits<float>::epsilon() * scale;
+    }
+
+    // Fails if the points do not span a tetrahedron
+    bool build() {
+        if (not start()) {
+            return false;
+        }
+        std::vector<std::uint32_t> pending{};
+        for (std::uint32_t f = 0; f != _faces.size(); ++f) {
+            pending.push_back(f);
+        }
+        while (not pending.empty()) {
+            const std::uint32_t f = pending.back();
+            pending.pop_back();
+            if (_faces[f].alive and not _faces[f].outside.empty()) {
+                add_point(f, pending);
+            }
+        }
+        return true;
+    }
+
+    const std::vector<face>& faces() const {
+        return _faces;
+    }
+
+private:
+    double distance(const face& f, const std::uint32_t p) const {
+        return geo::dot(f.normal, _points[p]) - f.offset;
+    }
+
+    face make_face(const std::uint32_t a, const std::uint32_t b, const std::uint32_t c) const {
+        const point n = geo::cross(_points[b] - _points[a], _points[c] - _points[a]);
+        const double length = std::sqrt(geo::dot(n, n));
+        const point normal = length > 0 ? n / length : point{ 0, 0, 0 };
+        return { .vertices = { a, b, c }, .neighbours = {}, .normal = normal, .offset = geo::dot(normal, _points[a]), .outside = {}, .alive = true };
+    }
+
+    std::uint32_t add_face(face f) {
+        const std::uint32_t index = static_cast<std::uint32_t>(_faces.size());
+        _faces.push_back(std::move(f));
+        _visited.push_back(0);
+        return index;
+    }
+
+    // Points the neighbour of `f` across the edge from `from` to `to` at `neighbour`
+    void link(face& f, const std::uint32_t from, const std::uint32_t to, const std::uint32_t neighbour) {
+        for (int k = 0; k != 3; ++k) {
+            if (f.vertices[k] == from and f.vertices[(k + 1) % 3] == to) {
+                f.neighbours[k] = neighbour;
+            }
+        }
+    }
+
+    // Gives the point to whichever of the faces it is furthest above, if it is above any of them at all
+    void assign(const std::uint32_t p, const std::uint32_t* const begin, const std::uint32_t* const end) {
+        double furthest = _tolerance;
+        const std::uint32_t* best = end;
+        for (const std::uint32_t* f = begin; f != end; ++f) {
+            if (const double d = distance(_faces[*f], p); d > furthest) {
+                furthest = d;
+                best = f;
+            }
+        }
+        if (best != end) {
+            _faces[*best].outside.push_back(p);
+        }
+    }
+
+    // The first tetrahedron, from the points furthest apart, then furthest from the line between them, then furthest from that plane
+    bool start() {
+        if (_points.size() < 4) {
+            return false;
+        }
+        std::array<std::uint32_t, 6> extremes{};
+        for (std::uint32_t p = 0; p != _points.size(); ++p) {
+            for (int axis = 0; axis != 3; ++axis) {
+                const auto at = [axis](const point& v) { return axis == 0 ? v.x : axis == 1 ? v.y : v.z; };
+                if (at(_points[p]) < at(_points[extremes[2 * axis]])) {
+                    extremes[2 * axis] = p;
+                }
+                if (at(_points[p]) > at(_points[extremes[2 * axis + 1]])) {
+                    extremes[2 * axis + 1] = p;
+                }
+            }
+        }
+
+        std::array<std::uint32_t, 4> corners{};
+        double furthest = 0;
+        for (const std::uint32_t a : extremes) {
+            for (const std::uint32_t b : extremes) {
+                const point d = _points[b] - _points[a];
+                if (const double length = geo::dot(d, d); length > furthest) {
+                    furthest = length;
+                    corners[0] = a;
+                    corners[1] = b;
+                }
+            }
+        }
+        if (std::sqrt(furthest) <= _tolerance) {
+            return false;
+        }
+
+        const point direction = _points[corners[1]] - _points[corners[0]];
+        furthest = 0;
+        for (std::uint32_t p = 0; p != _points.size(); ++p) {
+            const point off_line = geo::cross(_points[p] - _points[corners[0]], direction);
+            if (const double d = geo::dot(off_line, off_line); d > furthest) {
+                furthest = d;
+                corners[2] = p;
+            }
+        }
+        if (std::sqrt(furthest / geo::dot(direction, direction)) <= _tolerance) {
+            return false;
+        }
+
+        const face base = make_face(corners[0], corners[1], corners[2]);
+        furthest = 0;
+        for (std::uint32_t p = 0; p != _points.size(); ++p) {
+            if (const double d = std::abs(distance(base, p)); d > furthest) {
+                furthest = d;
+                corners[3] = p;
+            }
+        }
+        if (furthest <= _tolerance) {
+            return false;
+        }
+
+        // Each face is turned to point away from the middle of the tetrahedron
+        const point middle = (_points[corners[0]] + _points[corners[1]] + _points[corners[2]] + _points[corners[3]]) / 4.0;
+        for (const auto [a, b, c] : { std::array{ 0, 1, 2 }, std::array{ 0, 1, 3 }, std::array{ 0, 2, 3 }, std::array{ 1, 2, 3 } }) {
+            face f = make_face(corners[a], corners[b], corners[c]);
+            if (geo::dot(f.normal, middle) - f.offset > 0) {
+                f = make_face(corners[a], corners[c], corners[b]);
+            }
+            add_face(std::move(f));
+        }
+        for (face& f : _faces) {
+            for (std::uint32_t other = 0; other != _faces.size(); ++other) {
+                for (int k = 0; k != 3; ++k) {
+                    link(f, _faces[other].vertices[(k + 1) % 3], _faces[other].vertices[k], other);
+                }
+            }
+        }
+
+        const std::array<std::uint32_t, 4> first = { 0, 1, 2, 3 };
+        for (std::uint32_t p = 0; p != _points.size(); ++p) {
+            if (std::ranges::find(corners, p) == corners.end()) {
+                assign(p, first.data(), first.data() + first.size());
+            }
+        }
+        return true;
+    }
+
+    // Adds the point furthest above the face to the hull, replacing every face which it can see
+    void add_point(const std::uint32_t start, std::vector<std::uint32_t>& pending) {
+        const std::vector<std::uint32_t>& outside = _faces[start].outside;
+        const std::uint32_t apex = *std::ranges::max_element(outside, {}, [&](const std::uint32_t p) { return distance(_faces[start], p); });
+
+        // The visible faces are all connected, and the edges between them and the rest of the hull form the horizon
+        ++_pass;
+        std::vector<std::uint32_t> visible = { start };
+        struct horizon_edge {
+            std::uint32_t from;
+            std::uint32_t to;
+            std::uint32_t beyond; // The face on the far side of the horizon
+        };
+        std::vector<horizon_edge> horizon{};
+        _visited[start] = _pass;
+        for (std::size_t i = 0; i != visible.size(); ++i) {
+            const face& f = _faces[visible[i]];
+            for (int k = 0; k != 3; ++k) {
+                const std::uint32_t neighbour = f.neighbours[k];
+                if (_visited[neighbour] == _pass) {
+                    continue;
+                }
+                if (distance(_faces[neighbour], apex) > _tolerance) {
+                    _visited[neighbour] = _pass;
+                    visible.push_back(neighbour);
+                } else {
+                    horizon.push_back({ f.vertices[k], f.vertices[(k + 1) % 3], neighbour });
+                }
+            }
+        }
+
+        std::vector<std::uint32_t> orphans{};
+        for (const std::uint32_t f : visible) {
+            for (const std::uint32_t p : _faces[f].outside) {
+                if (p != apex) {
+                    orphans.push_back(p);
+                }
+            }
+            _faces[f].alive = false;
+            _faces[f].outside = {};
+        }
+
+        // Each new face joins one edge of the horizon to the apex, and meets the new faces on the edges before and after it
+        std::vector<std::uint32_t> added{};
+        for (const horizon_edge& edge : horizon) {
+            const std::uint32_t index = add_face(make_face(edge.from, edge.to, apex));
+            _faces[index].neighbours[0] = edge.beyond;
+            link(_faces[edge.beyond], edge.to, edge.from, index);
+            added.push_back(index);
+        }
+        for (const std::uint32_t a : added) {
+            for (const std::uint32_t b : added) {
+                face& f = _faces[a];
+                if (_faces[b].vertices[0] == f.vertices[1]) {
+                    f.neighbours[1] = b;
+                }
+                if (_faces[b].vertices[1] == f.vertices[0]) {
+                    f.neighbours[2] = b;
+                }
+            }
+        }
+        for (const std::uint32_t p : orphans) {
+            assign(p, added.data(), added.data() + added.size());
+        }
+        for (const std::uint32_t f : added) {
+            if (not _faces[f].outside.empty()) {
+                pending.push_back(f);
+            }
+        }
+    }
+
+    std::vector<point> _points{};
+    double _tolerance = 0;
+    std::vector<face> _faces{};
+    std::vector<std::uint32_t> _visited{}; // The last pass of `add_point` to find each face visible
+    std::uint32_t _pass = 0;
+};
+
+} // namespace
+
+mesh convex_hull(const mesh& mesh) {
+    hull_builder hull(mesh.vertices());
+    if (not hull.build()) {
+        return mesh;
+    }
+
+    mesh_builder builder{};
+    for (const face& f : hull.faces()) {
+        if (not f.alive) {
+            continue;
+        }
+        const geo::vector3<float> normal = { (float)f.normal.x, (float)f.normal.y, (float)f.normal.z };
+        builder.push_back({ normal, mesh.vertex(f.vertices[0]), mesh.vertex(f.vertices[1]), mesh.vertex(f.vertices[2]) });
+    }
+    return builder.build();
+}
+
+} // namespace pstack::calc
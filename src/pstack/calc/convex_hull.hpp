@@ -0,0 +1,16 @@
+#ifndef PSTACK_CALC_CONVEX_HULL_HPP
+#define PSTACK_CALC_CONVEX_HULL_HPP
+
+#include "pstack/calc/mesh.hpp"
+
+namespace pstack::calc {
+
+// The convex hull of the vertices of the mesh, found by quickhull [Barber, Dobkin & Huhdanpaa].
+// Its vertices are a subset of those of the mesh, so anything which only depends on the extremes of the mesh,
+// like its bounding box in any orientation, is the same for the hull, which usually has far fewer vertices.
+// A mesh which is flat or empty has no hull with any volume, and is returned as it is.
+mesh convex_hull(const mesh& mesh);
+
+} // namespace pstack::calc
+
+#endif // PSTACK_CALC_CONVEX_HULL_HPP
@@ -0,0 +1,68 @@
+#include "pstack/calc/extreme_points.hpp"
+#include <algorithm>
+#include <array>
+#include <tuple>
+
+namespace pstack::calc {
+
+namespace {
+
+constexpr int& at(geo::point3<int>& p, const int axis) {
+    return axis == 0 ? p.x : axis == 1 ? p.y : p.z;
+}
+
+constexpr int at(const geo::point3<int>& p, const int axis) {
+    return axis == 0 ? p.x : axis == 1 ? p.y : p.z;
+}
+
+constexpr auto scan_order(const geo::point3<int>& p) {
+    return std::tuple{ p.x + p.y + p.z, p.x + p.y, p.x };
+}
+
+} // namespace
+
+geo::point3<int> extreme_points::project(geo::point3<int> point, const int axis) const {
+    const int other1 = (axis + 1) % 3;
+    const int other2 = (axis + 2) % 3;
+    int projected = 0;
+    for (const box& b : _boxes) {
+        if (at(b.max, axis) <= at(point, axis) and at(b.max, axis) > projected
+            and at(b.min, other1) <= at(point, other1) and at(point, other1) < at(b.max, other1)
+            and at(b.min, other2) <= at(point, other2) and at(point, other2) < at(b.max, other2))
+        {
+            projected = at(b.max, axis);
+        }
+    }
+    at(point, axis) = projected;
+    return point;
+}
+
+void extreme_points::add_box(const geo::point3<int> position, const geo::vector3<int> size) {
+    const box added{ position, position + size };
+
+    // Points inside the new box are now occupied
+    std::erase_if(_points, [&](const geo::point3<int>& p) {
+        return added.contains(p);
+    });
+    _boxes.push_back(added);
+
+    std::array<geo::point3<int>, 9> new_points{};
+    auto it = new_points.begin();
+    for (int axis = 0; axis != 3; ++axis) {
+        geo::point3<int> corner = added.min;
+        at(corner, axis) = at(added.max, axis);
+        *it++ = corner;
+        *it++ = project(corner, (axis + 1) % 3);
+        *it++ = project(corner, (axis + 2) % 3);
+    }
+
+    for (const geo::point3<int>& p : new_points) {
+        const bool occupied = std::ranges::any_of(_boxes, [&](const box& b) { return b.contains(p); });
+        if (not occupied and std::ranges::find(_points, p) == _points.end()) {
+            const auto pos = std::ranges::upper_bound(_points, scan_order(p), {}, scan_order);
+            _points.insert(pos, p);
+        }
+    }
+}
+
+} // namespace pstack::calc
@@ -0,0 +1,45 @@
+#ifndef PSTACK_CALC_EXTREME_POINTS_HPP
+#define PSTACK_CALC_EXTREME_POINTS_HPP
+
+#include "pstack/geo/point3.hpp"
+#include "pstack/geo/vector3.hpp"
+#include <vector>
+
+namespace pstack::calc {
+
+// Candidate positions for the next placement, derived from the bounding boxes of the pieces placed so far.
+// Each placed box contributes the corners just past its far faces, and those corners projected back
+// along the other axes until they meet another box or a wall of the space.
+class extreme_points {
+public:
+    extreme_points() {
+        _points.push_back({ 0, 0, 0 });
+    }
+
+    void add_box(geo::point3<int> position, geo::vector3<int> size);
+
+    // Sorted in the same order as the full diagonal scan, so the first candidate that fits is the one the scan would prefer
+    const std::vector<geo::point3<int>>& points() const {
+        return _points;
+    }
+
+private:
+    struct box {
+        geo::point3<int> min;
+        geo::point3<int> max;
+
+        bool contains(const geo::point3<int>& p) const {
+            return min.x <= p.x and p.x < max.x
+               and min.y <= p.y and p.y < max.y
+               and min.z <= p.z and p.z < max.z;
+        }
+    };
+    std::vector<box> _boxes{};
+    std::vector<geo::point3<int>> _points{};
+
+    geo::point3<int> project(geo::point3<int> point, int axis) const;
+};
+
+} // namespace pstack::calc
+
+#endif // PSTACK_CALC_EXTREME_POINTS_HPP
@@ -0,0 +1,184 @@
+#include "pstack/calc/lattice.hpp"
+#include "pstack/util/mdarray.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <tuple>
+#include <utility>
+
+namespace pstack::calc {
+
+namespace {
+
+constexpr int floor_div(const int a, const int b) {
+    return a / b - ((a % b != 0) and ((a < 0) != (b < 0)));
+}
+
+constexpr int ceil_div(const int a, const int b) {
+    return -floor_div(-a, b);
+}
+
+// Which offsets between two copies of the part make them overlap, being where what one copy has taken meets the voxels of the other.
+// Each column of the part is split into runs of occupied voxels, and every pair of runs rules out a range of z offsets,
+// so the whole table is built without ever comparing individual voxels.
+class collision_table {
+public:
+    // Stops filling in the table once `running` is cleared, leaving it unusable
+    collision_table(const util::brick_grid<int>& voxels, const util::brick_grid<int>& taken, const int margin, const int index, const std::atomic<bool>& running)
+        : _extent{ (int)voxels.extent(0) + margin, (int)voxels.extent(1) + margin, (int)voxels.extent(2) + margin }
+        , _table(2 * _extent.x - 1, 2 * _extent.y - 1, 2 * _extent.z)
+    {
+        const std::vector<column> placed = columns(taken, index);
+        const std::vector<column> tested = columns(voxels, index);
+
+        // Mark the start and one past the end of each range of z offsets, then accumulate along z
+        for (const column& c1 : placed) {
+            if (not running) {
+                return;
+            }
+            for (const column& c2 : tested) {
+                const int dx = c1.i - margin - c2.i + _extent.x - 1;
+                const int dy = c1.j - margin - c2.j + _extent.y - 1;
+                for (const auto [bottom1, top1] : c1.runs) {
+                    for (const auto [bottom2, top2] : c2.runs) {
+                        ++_table[dx, dy, bottom1 - margin - top2 + _extent.z - 1];
+                        --_table[dx, dy, top1 - margin - bottom2 + _extent.z];
+                    }
+                }
+            }
+        }
+        for (int dx = 0; dx < _table.extent(0); ++dx) {
+            for (int dy = 0; dy < _table.extent(1); ++dy) {
+                for (int dz = 1; dz < _table.extent(2); ++dz) {
+                    _table[dx, dy, dz] += _table[dx, dy, dz - 1];
+                }
+            }
+        }
+    }
+
+    geo::vector3<int> extent() const {
+        return _extent;
+    }
+
+    bool collides(const geo::vector3<int> offset) const {
+        if (std::abs(offset.x) >= _extent.x or std::abs(offset.y) >= _extent.y or std::abs(offset.z) >= _extent.z) {
+            return false;
+        }
+        return _table[offset.x + _extent.x - 1, offset.y + _extent.y - 1, offset.z + _extent.z - 1] > 0;
+    }
+
+private:
+    struct column {
+        int i;
+        int j;
+        std::vector<std::pair<int, int>> runs;
+    };
+
+    static std::vector<column> columns(const util::brick_grid<int>& voxels, const int index) {
+        std::vector<column> result{};
+        for (int i = 0; i < voxels.extent(0); ++i) {
+            for (int j = 0; j < voxels.extent(1); ++j) {
+                column c{ i, j, {} };
+                for (int k = 0; k < voxels.extent(2); ++k) {
+                    const bool occupied = (voxels.at(i, j, k) & index) != 0;
+                    if (not occupied) {
+                        continue;
+                    } else if (not c.runs.empty() and c.runs.back().second == k - 1) {
+                        c.runs.back().second = k;
+                    } else {
+                        c.runs.emplace_back(k, k);
+                    }
+                }
+                if (not c.runs.empty()) {
+                    result.push_back(std::move(c));
+                }
+            }
+        }
+        return result;
+    }
+
+    geo::vector3<int> _extent;
+    util::mdarray<int, 3> _table;
+};
+
+// Whether any two copies in the lattice overlap. Overlap is symmetric, so only half of the lattice vectors need checking,
+// and only those short enough to reach from one bounding box into another.
+bool overlaps(const collision_table& table, const lattice& l) {
+    const geo::vector3<int> e = table.extent();
+    for (int k = 0; k * l.c.z < e.z; ++k) {
+        const int j_min = k == 0 ? 0 : ceil_div(1 - e.y - k * l.c.y, l.b.y);
+        const int j_max = floor_div(e.y - 1 - k * l.c.y, l.b.y);
+        for (int j = j_min; j <= j_max; ++j) {
+            const int x = j * l.b.x + k * l.c.x;
+            const int i_min = (k == 0 and j == 0) ? 1 : ceil_div(1 - e.x - x, l.a.x);
+            const int i_max = floor_div(e.x - 1 - x, l.a.x);
+            for (int i = i_min; i <= i_max; ++i) {
+                if (table.collides(i * l.a + j * l.b + k * l.c)) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+std::vector<geo::point3<int>> lattice::points(const geo::vector3<int> box_size, const geo::point3<int> max) const {
+    std::vector<geo::point3<int>> result{};
+    for (int k = 0; k * c.z + box_size.z < max.z; ++k) {
+        for (int j = ceil_div(-k * c.y, b.y); j * b.y + k * c.y + box_size.y < max.y; ++j) {
+            const int x = j * b.x + k * c.x;
+            for (int i = ceil_div(-x, a.x); x + i * a.x + box_size.x < max.x; ++i) {
+                result.push_back(geo::origin3<int> + (i * a + j * b + k * c));
+            }
+        }
+    }
+    std::ranges::sort(result, {}, [](const geo::point3<int>& p) {
+        return std::tuple{ p.z, p.x + p.y, p.x };
+    });
+    return result;
+}
+
+std::optional<lattice> find_lattice(const util::brick_grid<int>& voxels, const util::brick_grid<int>& taken, const int margin, const int index, const std::atomic<bool>& running) {
+    const collision_table table(voxels, taken, margin, index, running);
+    const geo::vector3<int> e = table.extent();
+
+    // Copies a whole bounding box apart never overlap, so start from there
+    lattice result{ .a = { e.x, 0, 0 }, .b = { 0, e.y, 0 }, .c = { 0, 0, e.z } };
+    for (int x = 1; x < e.x and running; ++x) {
+        if (not overlaps(table, { .a = { x, 0, 0 }, .b = result.b, .c = result.c })) {
+            result.a = { x, 0, 0 };
+            break;
+        }
+    }
+
+    // Any offset along `a` can be taken off the later vectors, so they only need to be searched within one cell
+    [&] {
+        for (int y = 1; y < e.y and running; ++y) {
+            for (int x = 0; x < result.a.x; ++x) {
+                if (not overlaps(table, { .a = result.a, .b = { x, y, 0 }, .c = result.c })) {
+                    result.b = { x, y, 0 };
+                    return;
+                }
+            }
+        }
+    }();
+    [&] {
+        for (int z = 1; z < e.z; ++z) {
+            for (int y = 0; y < result.b.y and running; ++y) {
+                for (int x = 0; x < result.a.x; ++x) {
+                    if (not overlaps(table, { .a = result.a, .b = result.b, .c = { x, y, z } })) {
+                        result.c = { x, y, z };
+                        return;
+                    }
+                }
+            }
+        }
+    }();
+    if (not running) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+} // namespace pstack::calc
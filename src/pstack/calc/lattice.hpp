@@ -0,0 +1,35 @@
+#ifndef PSTACK_CALC_LATTICE_HPP
+#define PSTACK_CALC_LATTICE_HPP
+
+#include "pstack/geo/point3.hpp"
+#include "pstack/geo/vector3.hpp"
+#include "pstack/util/brick_grid.hpp"
+#include <atomic>
+#include <optional>
+#include <vector>
+
+namespace pstack::calc {
+
+// A periodic packing of copies of one voxelized part, with a copy at every `i * a + j * b + k * c`.
+// The basis is kept in reduced form: `a` lies along x, `b` lies in the xy-plane, and all of `a.x`, `b.y`, and `c.z` are positive.
+struct lattice {
+    geo::vector3<int> a;
+    geo::vector3<int> b;
+    geo::vector3<int> c;
+
+    int cell_volume() const {
+        return a.x * b.y * c.z;
+    }
+
+    // Every lattice position at which a copy of size `box_size` lies within `[0, max)`, lowest layer first
+    std::vector<geo::point3<int>> points(geo::vector3<int> box_size, geo::point3<int> max) const;
+};
+
+// Greedily shortens each basis vector in turn, keeping the copies of the part with orientation `index` from overlapping.
+// Copies overlap where the `voxels` of one meet what another has `taken`, which reaches `margin` voxels past them on every side.
+// Gives up and returns nothing once `running` is cleared.
+std::optional<lattice> find_lattice(const util::brick_grid<int>& voxels, const util::brick_grid<int>& taken, int margin, int index, const std::atomic<bool>& running);
+
+} // namespace pstack::calc
+
+#endif // PSTACK_CALC_LATTICE_HPP
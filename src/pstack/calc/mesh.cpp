@@ -1,80 +1,141 @@
 #include "pstack/calc/mesh.hpp"
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
 namespace pstack::calc {
 
+namespace {
+
+void translate(mesh::coordinates& c, const geo::vector3<float> offset) {
+    geo::batch::transform(c.span(), c.span(), geo::translate4(offset.x, offset.y, offset.z));
+}
+
+void resize(mesh::coordinates& c, const std::size_t count) {
+    c.x.resize(count);
+    c.y.resize(count);
+    c.z.resize(count);
+}
+
+// `bounding` has always started its greatest values from `min()`, not `lowest()`, so they never come out any less than that
+mesh::bounding_t box(const geo::point3<float> min, geo::point3<float> max) {
+    constexpr float least_positive = std::numeric_limits<float>::min();
+    max = { std::max(max.x, least_positive), std::max(max.y, least_positive), std::max(max.z, least_positive) };
+    const geo::vector3<float> size = max - min;
+    return { .min = min, .max = max, .box_size = { geo::ceil(size.x + 2), geo::ceil(size.y + 2), geo::ceil(size.z + 2) } };
+}
+
+} // namespace
+
+void mesh::coordinates::reserve(const std::size_t count) {
+    x.reserve(count);
+    y.reserve(count);
+    z.reserve(count);
+}
+
+mesh::mesh(const std::vector<geo::triangle>& triangles) {
+    mesh_builder builder{};
+    builder.reserve(triangles.size());
+    for (const geo::triangle& t : triangles) {
+        builder.push_back(t);
+    }
+    *this = builder.build();
+}
+
+std::vector<geo::triangle> mesh::triangles() const {
+    std::vector<geo::triangle> out{};
+    out.reserve(triangle_count());
+    for (std::size_t i = 0; i != triangle_count(); ++i) {
+        out.push_back(triangle(i));
+    }
+    return out;
+}
+
 void mesh::add(const mesh& m, const geo::vector3<float> translation) {
-    _triangles.reserve(_triangles.size() + m._triangles.size());
-    for (const auto& t : m._triangles) {
-        auto& triangle = _triangles.emplace_back(t);
-        triangle.v1 += translation;
-        triangle.v2 += translation;
-        triangle.v3 += translation;
+    const std::uint32_t first = static_cast<std::uint32_t>(_vertices.size());
+    _vertices.x.insert(_vertices.x.end(), m._vertices.x.begin(), m._vertices.x.end());
+    _vertices.y.insert(_vertices.y.end(), m._vertices.y.begin(), m._vertices.y.end());
+    _vertices.z.insert(_vertices.z.end(), m._vertices.z.begin(), m._vertices.z.end());
+    for (std::size_t i = first; i != _vertices.size(); ++i) {
+        _vertices.x[i] += translation.x;
+        _vertices.y[i] += translation.y;
+        _vertices.z[i] += translation.z;
     }
+    _indices.reserve(_indices.size() + m._indices.size());
+    for (const std::uint32_t index : m._indices) {
+        _indices.push_back(first + index);
+    }
+    _normals.x.insert(_normals.x.end(), m._normals.x.begin(), m._normals.x.end());
+    _normals.y.insert(_normals.y.end(), m._normals.y.begin(), m._normals.y.end());
+    _normals.z.insert(_normals.z.end(), m._normals.z.begin(), m._normals.z.end());
 }
 
 void mesh::mirror_x() {
-    for (auto& t : _triangles) {
-        t.normal.x = -t.normal.x;
-        t.v1.x = -t.v1.x;
-        t.v2.x = -t.v2.x;
-        t.v3.x = -t.v3.x;
-        std::swap(t.v2, t.v3);
+    for (float& x : _normals.x) {
+        x = -x;
+    }
+    for (float& x : _vertices.x) {
+        x = -x;
+    }
+    // Swapping the last two vertices of each triangle keeps it facing outwards
+    for (std::size_t i = 0; i != _indices.size(); i += 3) {
+        std::swap(_indices[i + 1], _indices[i + 2]);
     }
 }
 
 void mesh::scale(const double factor) {
-    for (auto& t : _triangles) {
-        t.v1 = geo::origin3<float> + (factor * t.v1.as_vector());
-        t.v2 = geo::origin3<float> + (factor * t.v2.as_vector());
-        t.v3 = geo::origin3<float> + (factor * t.v3.as_vector());
+    const float f = static_cast<float>(factor);
+    for (std::vector<float>* stream : { &_vertices.x, &_vertices.y, &_vertices.z }) {
+        for (float& value : *stream) {
+            value *= f;
+        }
     }
 }
 
 void mesh::rotate(const geo::matrix3<float>& rotation) {
-    for (auto& t : _triangles) {
-        t.normal = rotation * t.normal;
-        t.v1 = geo::origin3<float> + (rotation * t.v1.as_vector());
-        t.v2 = geo::origin3<float> + (rotation * t.v2.as_vector());
-        t.v3 = geo::origin3<float> + (rotation * t.v3.as_vector());
-    }
+    geo::batch::transform(_normals.span(), _normals.span(), rotation);
+    geo::batch::transform(_vertices.span(), _vertices.span(), rotation);
 }
 
 geo::vector3<float> mesh::set_baseline(const geo::point3<float> baseline) {
     const geo::point3 min = bounding().min;
     const geo::vector3 offset = baseline - min;
-    for (auto& t : _triangles) {
-        t.v1 += offset;
-        t.v2 += offset;
-        t.v3 += offset;
-    }
+    translate(_vertices, offset);
     return offset;
 }
 
+void mesh::add_sinterbox(const sinterbox_parameters& params) {
+    std::vector<geo::triangle> triangles{};
+    append_sinterbox(triangles, params);
+    add(mesh(triangles), { 0, 0, 0 });
+}
+
 mesh::bounding_t mesh::bounding() const {
-    bounding_t out;
-    out.min = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
-    out.max = { std::numeric_limits<float>::min(), std::numeric_limits<float>::min(), std::numeric_limits<float>::min() };
-
-    for (const auto& triangle : _triangles) {
-        out.min.x = std::min({ out.min.x, triangle.v1.x, triangle.v2.x, triangle.v3.x });
-        out.min.y = std::min({ out.min.y, triangle.v1.y, triangle.v2.y, triangle.v3.y });
-        out.min.z = std::min({ out.min.z, triangle.v1.z, triangle.v2.z, triangle.v3.z });
-
-        out.max.x = std::max({ out.max.x, triangle.v1.x, triangle.v2.x, triangle.v3.x });
-        out.max.y = std::max({ out.max.y, triangle.v1.y, triangle.v2.y, triangle.v3.y });
-        out.max.z = std::max({ out.max.z, triangle.v1.z, triangle.v2.z, triangle.v3.z });
-    }
+    const geo::bounds3<float> bounds = geo::batch::bounds(_vertices.span());
+    return box(bounds.min, bounds.max);
+}
 
-    const geo::vector3<float> size = out.max - out.min;
-    out.box_size = { geo::ceil(size.x + 2), geo::ceil(size.y + 2), geo::ceil(size.z + 2) };
-    return out;
+mesh::transformed_t mesh::transform_into(mesh& out, const double factor, const geo::matrix3<float>& rotation, const geo::point3<float> baseline) const {
+    out._indices = _indices;
+    resize(out._normals, _normals.size());
+    resize(out._vertices, _vertices.size());
+    geo::batch::transform(_normals.span(), out._normals.span(), rotation);
+
+    // The first pass scales and rotates the vertices, keeping track of their bounds as it goes
+    const geo::bounds3<float> bounds = geo::batch::transform_bounds(_vertices.span(), out._vertices.span(), rotation * static_cast<float>(factor));
+
+    // And the second moves them onto the baseline, which moves their bounds along with them.
+    // Rounding never reorders two sums with the same offset, so these are still exactly the least and greatest of the moved vertices.
+    const geo::vector3<float> offset = baseline - bounds.min;
+    translate(out._vertices, offset);
+    return { .offset = offset, .bounding = box(bounds.min + offset, bounds.max + offset) };
 }
 
 mesh::volume_and_centroid_t mesh::volume_and_centroid() const {
     double total_volume = 0;
     geo::vector3<float> total_centroid = { 0, 0, 0 };
-    for (const auto& t : _triangles) {
+    for (std::size_t i = 0; i != triangle_count(); ++i) {
+        const geo::triangle t = triangle(i);
         const auto volume_piece = geo::dot(t.v1.as_vector(), geo::cross(t.v2.as_vector(), t.v3.as_vector()));
         total_volume += volume_piece;
         total_centroid += volume_piece * (t.v1.as_vector() + t.v2.as_vector() + t.v3.as_vector());
@@ -84,4 +145,43 @@ mesh::volume_and_centroid_t mesh::volume_and_centroid() const {
     return { .volume = total_volume / 6, .centroid = ((total_centroid / 4) / total_volume) + geo::origin3<float> };
 }
 
+void mesh_builder::reserve(const std::size_t triangles) {
+    // Closed meshes have about half as many vertices as triangles
+    _mesh._vertices.reserve(triangles / 2);
+    _mesh._indices.reserve(3 * triangles);
+    _mesh._normals.reserve(triangles);
+    _welded.reserve(triangles / 2);
+}
+
+void mesh_builder::push_back(const geo::triangle& t) {
+    _mesh._indices.push_back(weld(t.v1));
+    _mesh._indices.push_back(weld(t.v2));
+    _mesh._indices.push_back(weld(t.v3));
+    _mesh._normals.x.push_back(t.normal.x);
+    _mesh._normals.y.push_back(t.normal.y);
+    _mesh._normals.z.push_back(t.normal.z);
+}
+
+std::size_t mesh_builder::grid_point_hash::operator()(const grid_point& p) const {
+    std::uint64_t hash = static_cast<std::uint64_t>(p[0]);
+    hash = hash * 0x9E3779B97F4A7C15 ^ static_cast<std::uint64_t>(p[1]);
+    hash = hash * 0x9E3779B97F4A7C15 ^ static_cast<std::uint64_t>(p[2]);
+    return static_cast<std::size_t>(hash ^ (hash >> 32));
+}
+
+std::uint32_t mesh_builder::weld(const geo::point3<float> position) {
+    const grid_point key = {
+        std::llround(position.x / weld_spacing),
+        std::llround(position.y / weld_spacing),
+        std::llround(position.z / weld_spacing),
+    };
+    const auto [it, inserted] = _welded.try_emplace(key, static_cast<std::uint32_t>(_mesh._vertices.size()));
+    if (inserted) {
+        _mesh._vertices.x.push_back(position.x);
+        _mesh._vertices.y.push_back(position.y);
+        _mesh._vertices.z.push_back(position.z);
+    }
+    return it->second;
+}
+
 } // namespace pstack::calc
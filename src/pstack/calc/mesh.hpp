@@ -2,24 +2,84 @@
 #define PSTACK_CALC_MESH_HPP
 
 #include "pstack/calc/sinterbox.hpp"
+#include "pstack/geo/batch.hpp"
 #include "pstack/geo/functions.hpp"
 #include "pstack/geo/matrix3.hpp"
 #include "pstack/geo/triangle.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace pstack::calc {
 
+class mesh_builder;
+
 class mesh {
+public:
+    // Each coordinate in a stream of its own, so that they can be transformed in batches by `geo::batch`
+    struct coordinates {
+        std::vector<float> x{};
+        std::vector<float> y{};
+        std::vector<float> z{};
+
+        std::size_t size() const {
+            return x.size();
+        }
+
+        geo::span3<float> span() {
+            return { x, y, z };
+        }
+        geo::span3<const float> span() const {
+            return { x, y, z };
+        }
+
+        void reserve(std::size_t count);
+    };
+
 private:
-    std::vector<geo::triangle> _triangles{};
+    friend class mesh_builder;
+
+    coordinates _vertices{}; // Shared by all the triangles which meet at them
+    std::vector<std::uint32_t> _indices{}; // Three vertices for each triangle, one after another
+    coordinates _normals{}; // One for each triangle
 
 public:
     mesh() = default;
-    mesh(std::vector<geo::triangle> triangles)
-        : _triangles(std::move(triangles)) {}
+    mesh(const std::vector<geo::triangle>& triangles);
+
+    std::size_t triangle_count() const {
+        return _normals.size();
+    }
+
+    geo::point3<float> vertex(const std::uint32_t index) const {
+        return { _vertices.x[index], _vertices.y[index], _vertices.z[index] };
+    }
 
-    const std::vector<geo::triangle>& triangles() const& {
-        return _triangles;
+    geo::triangle triangle(const std::size_t index) const {
+        return {
+            { _normals.x[index], _normals.y[index], _normals.z[index] },
+            vertex(_indices[3 * index]),
+            vertex(_indices[3 * index + 1]),
+            vertex(_indices[3 * index + 2]),
+        };
+    }
+
+    // Gathered into whole triangles, for code which needs them one at a time
+    std::vector<geo::triangle> triangles() const;
+
+    const coordinates& vertices() const& {
+        return _vertices;
+    }
+
+    const std::vector<std::uint32_t>& indices() const& {
+        return _indices;
+    }
+
+    const coordinates& normals() const& {
+        return _normals;
     }
 
     void add(const mesh& m, const geo::vector3<float> translation);
@@ -29,9 +89,7 @@ public:
     void rotate(const geo::matrix3<float>& rotation);
     geo::vector3<float> set_baseline(const geo::point3<float> baseline);
 
-    void add_sinterbox(const sinterbox_parameters& params) {
-        append_sinterbox(_triangles, params);
-    }
+    void add_sinterbox(const sinterbox_parameters& params);
 
     struct bounding_t {
         geo::point3<float> min;
@@ -41,6 +99,15 @@ public:
 
     bounding_t bounding() const;
 
+    struct transformed_t {
+        geo::vector3<float> offset; // As returned by `set_baseline`
+        bounding_t bounding; // Of `out`, once it is on the baseline
+    };
+
+    // The same as copying the mesh into `out` and then calling `scale`, `rotate`, `set_baseline` and `bounding` on it,
+    // but takes only two passes over the vertices. Reusing `out` between calls also reuses its storage.
+    transformed_t transform_into(mesh& out, double factor, const geo::matrix3<float>& rotation, const geo::point3<float> baseline) const;
+
     struct volume_and_centroid_t {
         double volume;
         geo::point3<float> centroid;
@@ -49,6 +116,34 @@ public:
     volume_and_centroid_t volume_and_centroid() const;
 };
 
+// Builds a mesh one triangle at a time, welding together the corners which the triangles share into a single vertex.
+// Corners are the same vertex when their positions round to the same point on a grid `weld_spacing` apart,
+// and the vertex keeps the position of the first of them.
+class mesh_builder {
+public:
+    static constexpr double weld_spacing = 1.0 / 4096;
+
+    void reserve(std::size_t triangles);
+    void push_back(const geo::triangle& triangle);
+
+    mesh build() {
+        _welded.clear();
+        return std::move(_mesh);
+    }
+
+private:
+    using grid_point = std::array<std::int64_t, 3>;
+
+    struct grid_point_hash {
+        std::size_t operator()(const grid_point& p) const;
+    };
+
+    std::uint32_t weld(const geo::point3<float> position);
+
+    mesh _mesh{};
+    std::unordered_map<grid_point, std::uint32_t, grid_point_hash> _welded{};
+};
+
 } // namespace pstack::calc
 
 #endif // PSTACK_CALC_MESH_HPP
@@ -0,0 +1,276 @@
+#include "pstack/calc/convex_hull.hpp"
+#include "pstack/calc/min_box.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <vector>
+
+namespace pstack::calc {
+
+namespace {
+
+using vector = geo::vector3<double>;
+
+// How many of the planes with the most area on the hull are tried as the base of the box,
+// and how many of its longest edges are paired up to make more of them
+constexpr std::size_t candidate_planes = 64;
+constexpr std::size_t candidate_edges = 12;
+
+// How much smaller a box must be to replace another, so that rounding alone never turns a part which is already lined up
+constexpr double least_gain = 1e-6;
+
+vector unit(const vector v) {
+    return v / std::sqrt(geo::dot(v, v));
+}
+
+struct box {
+    std::array<vector, 3> axes; // Orthonormal
+    std::array<double, 3> extents;
+
+    double volume() const {
+        return extents[0] * extents[1] * extents[2];
+    }
+
+    bool smaller_than(const box& other) const {
+        return volume() < other.volume() * (1 - least_gain);
+    }
+};
+
+box measure(const std::vector<vector>& points, const std::array<vector, 3>& axes) {
+    box out{ axes, {} };
+    for (int a = 0; a != 3; ++a) {
+        double min = std::numeric_limits<double>::infinity();
+        double max = -std::numeric_limits<double>::infinity();
+        for (const vector& p : points) {
+            const double d = geo::dot(axes[a], p);
+            min = std::min(min, d);
+            max = std::max(max, d);
+        }
+        out.extents[a] = max - min;
+    }
+    return out;
+}
+
+struct flat {
+    double u;
+    double v;
+};
+
+double dot(const flat a, const flat b) {
+    return a.u * b.u + a.v * b.v;
+}
+
+double cross(const flat o, const flat a, const flat b) {
+    return (a.u - o.u) * (b.v - o.v) - (a.v - o.v) * (b.u - o.u);
+}
+
+// Counter-clockwise, without any points in the middle of an edge [Andrew's monotone chain]
+std::vector<flat> flat_hull(std::vector<flat> points) {
+    std::ranges::sort(points, [](const flat a, const flat b) { return a.u < b.u or (a.u == b.u and a.v < b.v); });
+    if (points.size() < 3) {
+        return points;
+    }
+    std::vector<flat> hull(2 * points.size());
+    std::size_t count = 0;
+    for (std::size_t i = 0; i != points.size(); ++i) {
+        while (count >= 2 and cross(hull[count - 2], hull[count - 1], points[i]) <= 0) {
+            --count;
+        }
+        hull[count++] = points[i];
+    }
+    for (std::size_t i = points.size() - 1, lower = count + 1; i-- != 0; ) {
+        while (count >= lower and cross(hull[count - 2], hull[count - 1], points[i]) <= 0) {
+            --count;
+        }
+        hull[count++] = points[i];
+    }
+    hull.resize(count - 1);
+    return hull;
+}
+
+// The direction of one side of the rectangle of least area around a convex polygon, which always has a side along one of the edges.
+// Three calipers follow the points furthest along the edge, furthest from it, and furthest back along it, as the edge goes around.
+flat least_area_direction(const std::vector<flat>& hull) {
+    const std::size_t n = hull.size();
+    if (n < 3) {
+        return { 1, 0 };
+    }
+    const auto advance = [&](std::size_t& p, const auto& key) {
+        for (std::size_t steps = 0; steps != n and key(hull[(p + 1) % n]) >= key(hull[p]); ++steps) {
+            p = (p + 1) % n;
+        }
+    };
+
+    double least = std::numeric_limits<double>::infinity();
+    flat best = { 1, 0 };
+    std::size_t ahead = 0;
+    std::size_t above = 0;
+    std::size_t behind = 0;
+    for (std::size_t i = 0; i != n; ++i) {
+        const flat& next = hull[(i + 1) % n];
+        const double length = std::hypot(next.u - hull[i].u, next.v - hull[i].v);
+        if (length == 0) {
+            continue;
+        }
+        const flat along = { (next.u - hull[i].u) / length, (next.v - hull[i].v) / length };
+        const flat up = { -along.v, along.u };
+        advance(ahead, [&](const flat q) { return dot(q, along); });
+        if (i == 0) {
+            above = ahead;
+        }
+        advance(above, [&](const flat q) { return dot(q, up); });
+        if (i == 0) {
+            behind = above;
+        }
+        advance(behind, [&](const flat q) { return -dot(q, along); });
+
+        const double area = (dot(hull[ahead], along) - dot(hull[behind], along)) * (dot(hull[above], up) - dot(hull[i], up));
+        if (area < least) {
+            least = area;
+            best = along;
+        }
+    }
+    return best;
+}
+
+// The smallest box with one face in the plane with the given normal
+box fit_to_plane(const std::vector<vector>& points, const vector normal) {
+    const vector a = unit(geo::cross(normal, std::abs(normal.x) < 0.9 ? geo::unit_x<double> : geo::unit_y<double>));
+    const vector b = geo::cross(normal, a);
+    std::vector<flat> projected{};
+    projected.reserve(points.size());
+    for (const vector& p : points) {
+        projected.push_back({ geo::dot(a, p), geo::dot(b, p) });
+    }
+    const flat along = least_area_direction(flat_hull(std::move(projected)));
+    const vector side = along.u * a + along.v * b;
+    return measure(points, { side, geo::cross(normal, side), normal });
+}
+
+// Directions which only differ in which way they point are the same, and so are those within a hair of each other
+using direction_key = std::array<std::int64_t, 3>;
+
+direction_key key_of(vector& direction) {
+    if (direction.x < 0 or (direction.x == 0 and (direction.y < 0 or (direction.y == 0 and direction.z < 0)))) {
+        direction = -direction;
+    }
+    constexpr double precision = 1e5;
+    return { std::llround(direction.x * precision), std::llround(direction.y * precision), std::llround(direction.z * precision) };
+}
+
+// The `count` directions with the greatest total weight
+std::vector<vector> heaviest(const std::map<direction_key, std::pair<double, vector>>& weights, const std::size_t count) {
+    std::vector<std::pair<double, vector>> ranked{};
+    for (const auto& [key, weight] : weights) {
+        ranked.push_back(weight);
+    }
+    const std::size_t kept = std::min(count, ranked.size());
+    std::ranges::partial_sort(ranked, ranked.begin() + kept, std::greater{}, &std::pair<double, vector>::first);
+    std::vector<vector> out{};
+    for (std::size_t i = 0; i != kept; ++i) {
+        out.push_back(ranked[i].second);
+    }
+    return out;
+}
+
+// The planes which the box is tried lying flat on. The smallest box always has two sides which each touch an edge of the hull along its length,
+// and usually lies flat on a face [O'Rourke], so these are the planes with the most area on the hull, and the planes through pairs of its longest edges.
+std::vector<vector> candidate_normals(const mesh& hull) {
+    std::map<direction_key, std::pair<double, vector>> planes{};
+    std::map<direction_key, std::pair<double, vector>> edges{};
+    for (std::size_t i = 0; i != hull.triangle_count(); ++i) {
+        const geo::triangle t = hull.triangle(i);
+        const std::array<vector, 3> corners = { vector{ t.v1.x, t.v1.y, t.v1.z }, vector{ t.v2.x, t.v2.y, t.v2.z }, vector{ t.v3.x, t.v3.y, t.v3.z } };
+        const vector n = geo::cross(corners[1] - corners[0], corners[2] - corners[0]);
+        if (const double area = std::sqrt(geo::dot(n, n)); area > 0) {
+            vector normal = n / area;
+            planes.try_emplace(key_of(normal), 0, normal).first->second.first += area;
+        }
+        for (int k = 0; k != 3; ++k) {
+            const vector e = corners[(k + 1) % 3] - corners[k];
+            if (const double length = std::sqrt(geo::dot(e, e)); length > 0) {
+                vector direction = e / length;
+                edges.try_emplace(key_of(direction), 0, direction).first->second.first += length;
+            }
+        }
+    }
+
+    std::vector<vector> out = heaviest(planes, candidate_planes);
+    const std::vector<vector> longest = heaviest(edges, candidate_edges);
+    for (std::size_t i = 0; i != longest.size(); ++i) {
+        for (std::size_t j = i + 1; j != longest.size(); ++j) {
+            const vector n = geo::cross(longest[i], longest[j]);
+            if (const double length = std::sqrt(geo::dot(n, n)); length > 1e-6) {
+                out.push_back(n / length);
+            }
+        }
+    }
+    return out;
+}
+
+// Turns the box about each of its axes in steps which shrink until they no longer help
+box refine(const std::vector<vector>& points, box best) {
+    for (double step = 0.02; step > 1e-5; step /= 2) {
+        for (bool improved = true; improved; ) {
+            improved = false;
+            for (int axis = 0; axis != 3; ++axis) {
+                for (const double angle : { step, -step }) {
+                    std::array<vector, 3> axes = best.axes;
+                    vector& a = axes[(axis + 1) % 3];
+                    vector& b = axes[(axis + 2) % 3];
+                    const vector turned_a = std::cos(angle) * a + std::sin(angle) * b;
+                    b = std::cos(angle) * b - std::sin(angle) * a;
+                    a = turned_a;
+                    if (const box tried = measure(points, axes); tried.smaller_than(best)) {
+                        best = tried;
+                        improved = true;
+                    }
+                }
+            }
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+geo::matrix3<float> min_box_rotation(const mesh& mesh) {
+    const calc::mesh hull = convex_hull(mesh);
+    const calc::mesh::coordinates& vertices = hull.vertices();
+    std::vector<vector> points{};
+    points.reserve(vertices.size());
+    for (std::size_t i = 0; i != vertices.size(); ++i) {
+        points.push_back({ vertices.x[i], vertices.y[i], vertices.z[i] });
+    }
+    if (points.empty()) {
+        return geo::eye3<float>;
+    }
+
+    const box current = measure(points, { geo::unit_x<double>, geo::unit_y<double>, geo::unit_z<double> });
+    box best = current;
+    for (const vector& normal : candidate_normals(hull)) {
+        if (const box fitted = fit_to_plane(points, normal); fitted.smaller_than(best)) {
+            best = fitted;
+        }
+    }
+    best = refine(points, best);
+    if (not best.smaller_than(current)) {
+        best = current;
+    }
+
+    // Longest side first, and the last axis made to follow from the first two, so that this is a rotation rather than a reflection
+    std::array<std::size_t, 3> order = { 0, 1, 2 };
+    std::ranges::stable_sort(order, std::greater{}, [&](const std::size_t a) { return best.extents[a]; });
+    const vector x = best.axes[order[0]];
+    const vector y = best.axes[order[1]];
+    const vector z = geo::cross(x, y);
+    return { (float)x.x, (float)x.y, (float)x.z,
+             (float)y.x, (float)y.y, (float)y.z,
+             (float)z.x, (float)z.y, (float)z.z };
+}
+
+} // namespace pstack::calc
@@ -0,0 +1,17 @@
+#ifndef PSTACK_CALC_MIN_BOX_HPP
+#define PSTACK_CALC_MIN_BOX_HPP
+
+#include "pstack/calc/mesh.hpp"
+#include "pstack/geo/matrix3.hpp"
+
+namespace pstack::calc {
+
+// The rotation which lines up the smallest box around the mesh with the axes, with the longest side of the box along x and the shortest along z.
+// Each candidate box lies flat on one of the largest faces of the convex hull, or on a plane through two of its longest edges,
+// and is fitted around the hull by rotating calipers [Toussaint].
+// The best of them is then refined by small turns about each of its axes, and kept only if it is smaller than the box the mesh already has.
+geo::matrix3<float> min_box_rotation(const mesh& mesh);
+
+} // namespace pstack::calc
+
+#endif // PSTACK_CALC_MIN_BOX_HPP
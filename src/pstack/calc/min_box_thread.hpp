@@ -0,0 +1,84 @@
+#ifndef PSTACK_CALC_MIN_BOX_THREAD_HPP
+#define PSTACK_CALC_MIN_BOX_THREAD_HPP
+
+#include "pstack/calc/mesh.hpp"
+#include "pstack/calc/min_box.hpp"
+#include "pstack/geo/matrix3.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace pstack::calc {
+
+// Works out the smallest boxes of meshes on a thread of its own, so that the thread asking for them is not held up.
+// Unlike previews, every request is for a different part, so they are all worked out in the order they were asked for.
+class min_box_thread {
+public:
+    min_box_thread() = default;
+    ~min_box_thread() {
+        stop();
+    }
+
+    // Calls `on_finish` on the worker thread with the `min_box_rotation` of `mesh`
+    void start(calc::mesh mesh, std::function<void(geo::matrix3<float>)> on_finish) {
+        {
+            std::lock_guard lock(_mutex);
+            _requests.push_back({ std::move(mesh), std::move(on_finish) });
+        }
+        _wake.notify_one();
+        if (not _thread.has_value()) {
+            _thread.emplace([this] { run(); });
+        }
+    }
+
+    // Drops the requests which are still waiting, and waits for the one being worked out
+    void stop() {
+        {
+            std::lock_guard lock(_mutex);
+            _stopping = true;
+            _requests.clear();
+        }
+        _wake.notify_one();
+        if (_thread.has_value() and _thread->joinable()) {
+            _thread->join();
+        }
+        _thread.reset();
+        _stopping = false;
+    }
+
+private:
+    struct request {
+        calc::mesh mesh;
+        std::function<void(geo::matrix3<float>)> on_finish;
+    };
+
+    void run() {
+        while (true) {
+            request next;
+            {
+                std::unique_lock lock(_mutex);
+                _wake.wait(lock, [this] { return _stopping or not _requests.empty(); });
+                if (_stopping) {
+                    return;
+                }
+                next = std::move(_requests.front());
+                _requests.pop_front();
+            }
+            next.on_finish(min_box_rotation(next.mesh));
+        }
+    }
+
+    std::optional<std::thread> _thread{};
+    std::mutex _mutex{};
+    std::condition_variable _wake{};
+    std::deque<request> _requests{};
+    bool _stopping = false;
+};
+
+} // namespace pstack::calc
+
+#endif // PSTACK_CALC_MIN_BOX_THREAD_HPP
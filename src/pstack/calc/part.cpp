@@ -1,6 +1,8 @@
 #include "pstack/calc/part.hpp"
+#include "pstack/calc/min_box.hpp"
 #include "pstack/files/stl.hpp"
 #include <charconv>
+#include <cstddef>
 #include <cmath>
 #include <filesystem>
 #include <optional>
@@ -10,6 +12,15 @@ namespace pstack::calc {
 
 namespace {
 
+// Corners shared between triangles are welded as they are read, so the whole triangle soup is never held at once
+mesh read_mesh(const std::string& file_path) {
+    mesh_builder builder{};
+    files::from_stl(file_path,
+        [&](const std::size_t triangles) { builder.reserve(triangles); },
+        [&](const geo::triangle& triangle) { builder.push_back(triangle); });
+    return builder.build();
+}
+
 std::optional<int> get_base_quantity(std::string name) {
     char looking_for = '.';
     if (name.ends_with(')')) {
@@ -35,7 +46,7 @@ part initialize_part(part_base base) {
     part result{ std::move(base) };
 
     result.name = std::filesystem::path(result.mesh_file).stem().string();
-    result.mesh = files::from_stl(result.mesh_file);
+    result.mesh = read_mesh(result.mesh_file);
     result.mesh.set_baseline({ 0, 0, 0 });
 
     result.base_quantity = get_base_quantity(result.name);
@@ -43,7 +54,12 @@ part initialize_part(part_base base) {
     auto volume_and_centroid = result.mesh.volume_and_centroid();
     result.volume = volume_and_centroid.volume;
     result.centroid = volume_and_centroid.centroid;
-    result.triangle_count = result.mesh.triangles().size();
+    result.triangle_count = result.mesh.triangle_count();
+
+    // A part restored with `rotate_min_box` set keeps its smallest box from now on, rather than working it out on every stacking run
+    if (result.rotate_min_box) {
+        result.min_box_rotation = min_box_rotation(result.mesh);
+    }
 
     return result;
 }
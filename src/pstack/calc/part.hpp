@@ -27,6 +27,9 @@ struct part : part_base {
     double volume;
     geo::point3<float> centroid;
     int triangle_count;
+
+    // Used when `rotate_min_box` is set. Only worked out once asked for, or when a part is loaded with it set, as it is too slow to do for every part loaded.
+    std::optional<geo::matrix3<float>> min_box_rotation;
 };
 
 part initialize_part(part_base base);
@@ -0,0 +1,50 @@
+#include "pstack/calc/preview.hpp"
+#include "pstack/calc/voxel_mesh.hpp"
+#include "pstack/util/brick_grid.hpp"
+
+namespace pstack::calc {
+
+voxel_preview::voxel_preview(const mesh& mesh, const double resolution, const fill_mode fill, const double clearance)
+    : _mesh(mesh)
+    , _resolution(resolution)
+    , _fill(fill)
+    , _gap(clearance / resolution)
+{
+    _mesh.scale(1 / resolution);
+    _offset = _mesh.set_baseline({ 0, 0, 0 });
+    const geo::vector3<int> size = _mesh.bounding().box_size;
+    _surface = { size.x, size.y, size.z };
+    _solid = { size.x, size.y, size.z };
+    voxelize_surface(_mesh, _surface);
+    release_scratch_grids();
+}
+
+mesh voxel_preview::voxelize(const std::size_t min_hole) {
+    fill_surface(_mesh, _surface, _solid, min_hole, _fill);
+
+    // The same dilation as the stacker uses, so that the preview shows exactly what placing the part takes up.
+    // With a clearance, that reaches `margin` voxels past the part on every side.
+    const int margin = _gap > 0 ? clearance_margin(_gap) : 0;
+    util::brick_grid<int> voxels(_solid.extent(0) + 2 * margin, _solid.extent(1) + 2 * margin, _solid.extent(2) + 2 * margin);
+    if (_gap > 0) {
+        dilate(_solid, voxels, 1, _gap);
+    } else {
+        dilate(_solid, voxels, 1);
+    }
+    util::mdarray<Bool, 3> taken(voxels.extent(0), voxels.extent(1), voxels.extent(2));
+    for (std::size_t x = 0; x < taken.extent(0); ++x) {
+        for (std::size_t y = 0; y < taken.extent(1); ++y) {
+            for (std::size_t z = 0; z < taken.extent(2); ++z) {
+                taken[x, y, z] = voxels.at(x, y, z) != 0;
+            }
+        }
+    }
+
+    release_scratch_grids(); // Only one part is previewed now and then, so there is nothing to reuse them for
+
+    const geo::vector3<float> shift = _offset + geo::vector3<float>{ (float)margin, (float)margin, (float)margin };
+    const geo::point3<float> origin = geo::origin3<float> + (float)-_resolution * shift;
+    return voxel_mesh(taken, origin, _resolution);
+}
+
+} // namespace pstack::calc
@@ -0,0 +1,34 @@
+#ifndef PSTACK_CALC_PREVIEW_HPP
+#define PSTACK_CALC_PREVIEW_HPP
+
+#include "pstack/calc/bool.hpp"
+#include "pstack/calc/mesh.hpp"
+#include "pstack/calc/voxelize.hpp"
+#include "pstack/geo/vector3.hpp"
+#include "pstack/util/mdarray.hpp"
+#include <cstddef>
+
+namespace pstack::calc {
+
+// Voxelizes a single part the way the stacker does, so that the effect of its minimum hole size can be checked beforehand.
+// The surface of the part is only rendered once, and trying another minimum hole size only repeats the carving, filling, and dilation.
+class voxel_preview {
+public:
+    voxel_preview(const mesh& mesh, double resolution, fill_mode fill, double clearance);
+
+    // The voxels taken up with a minimum hole size of `min_hole`, including the clearance, as a mesh lying over the original part
+    mesh voxelize(std::size_t min_hole);
+
+private:
+    mesh _mesh; // Scaled onto the voxel grid
+    geo::vector3<float> _offset; // From the part to the voxel grid, once scaled
+    double _resolution;
+    fill_mode _fill;
+    double _gap; // The clearance, in voxels
+    util::mdarray<Bool, 3> _surface;
+    util::mdarray<Bool, 3> _solid;
+};
+
+} // namespace pstack::calc
+
+#endif // PSTACK_CALC_PREVIEW_HPP
@@ -0,0 +1,109 @@
+#ifndef PSTACK_CALC_PREVIEW_THREAD_HPP
+#define PSTACK_CALC_PREVIEW_THREAD_HPP
+
+#include "pstack/calc/mesh.hpp"
+#include "pstack/calc/preview.hpp"
+#include "pstack/calc/voxelize.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace pstack::calc {
+
+// Works out voxel previews on a thread of its own, so that the thread asking for them is not held up.
+// Only the latest request waits while another is being worked out, since any before it would be out of date once shown.
+class preview_thread {
+public:
+    preview_thread() = default;
+    ~preview_thread() {
+        stop();
+    }
+
+    // Voxelizes `mesh` afresh, then calls `on_finish` on the preview thread with the voxels it takes up with a minimum hole size of `min_hole`
+    void start(calc::mesh mesh, const double resolution, const fill_mode fill, const double clearance, const std::size_t min_hole, std::function<void(calc::mesh)> on_finish) {
+        push({ std::move(mesh), resolution, fill, clearance, min_hole, std::move(on_finish) });
+    }
+
+    // As above, trying another minimum hole size on the mesh last started
+    void refill(const std::size_t min_hole, std::function<void(calc::mesh)> on_finish) {
+        push({ std::nullopt, 0, {}, 0, min_hole, std::move(on_finish) });
+    }
+
+    void stop() {
+        {
+            std::lock_guard lock(_mutex);
+            _stopping = true;
+            _request.reset();
+        }
+        _wake.notify_one();
+        if (_thread.has_value() and _thread->joinable()) {
+            _thread->join();
+        }
+        _thread.reset();
+        _stopping = false;
+    }
+
+private:
+    struct request {
+        std::optional<calc::mesh> mesh; // Only set when the surface has to be voxelized again
+        double resolution;
+        fill_mode fill;
+        double clearance;
+        std::size_t min_hole;
+        std::function<void(calc::mesh)> on_finish;
+    };
+
+    void push(request next) {
+        {
+            std::lock_guard lock(_mutex);
+            if (not next.mesh.has_value() and _request.has_value() and _request->mesh.has_value()) {
+                // The waiting request was never started, so its mesh still needs voxelizing
+                next.mesh = std::move(_request->mesh);
+                next.resolution = _request->resolution;
+                next.fill = _request->fill;
+                next.clearance = _request->clearance;
+            }
+            _request = std::move(next);
+        }
+        _wake.notify_one();
+        if (not _thread.has_value()) {
+            _thread.emplace([this] { run(); });
+        }
+    }
+
+    void run() {
+        std::optional<voxel_preview> preview{};
+        while (true) {
+            request next;
+            {
+                std::unique_lock lock(_mutex);
+                _wake.wait(lock, [this] { return _stopping or _request.has_value(); });
+                if (_stopping) {
+                    return;
+                }
+                next = std::move(*_request);
+                _request.reset();
+            }
+            if (next.mesh.has_value()) {
+                preview.emplace(*next.mesh, next.resolution, next.fill, next.clearance);
+            }
+            if (preview.has_value()) {
+                next.on_finish(preview->voxelize(next.min_hole));
+            }
+        }
+    }
+
+    std::optional<std::thread> _thread{};
+    std::mutex _mutex{};
+    std::condition_variable _wake{};
+    std::optional<request> _request{};
+    bool _stopping = false;
+};
+
+} // namespace pstack::calc
+
+#endif // PSTACK_CALC_PREVIEW_THREAD_HPP
@@ -1,10 +1,16 @@
 #include "pstack/calc/bool.hpp"
+#include "pstack/calc/extreme_points.hpp"
+#include "pstack/calc/lattice.hpp"
 #include "pstack/calc/mesh.hpp"
+#include "pstack/calc/min_box.hpp"
 #include "pstack/calc/rotations.hpp"
 #include "pstack/calc/stacker.hpp"
 #include "pstack/calc/voxelize.hpp"
+#include "pstack/util/brick_grid.hpp"
 #include "pstack/util/mdarray.hpp"
+#include "pstack/util/parallel.hpp"
 #include <algorithm>
+#include <cmath>
 #include <optional>
 #include <ranges>
 
@@ -21,6 +27,12 @@ void stack_result::reload_mesh() {
 
 namespace {
 
+// With `tile_lattices`, parts with at least this many instances are tiled along a lattice before they are placed one at a time
+constexpr std::size_t lattice_quantity = 16;
+
+// How many times finer the grid is which arbitrary rotations are resampled from, when resampling
+constexpr int resample_factor = 2;
+
 struct stack_state {
     struct mesh_entry {
         mesh mesh;
@@ -28,46 +40,133 @@ struct stack_state {
         stack_result::piece piece;
     };
 
+    // The lowest and highest occupied voxel of one vertical column of a part
+    struct column {
+        int i;
+        int j;
+        int bottom;
+        int top;
+    };
+
     std::vector<std::vector<mesh_entry>> meshes;
-    std::vector<util::mdarray<int, 3>> voxels;
-    util::mdarray<Bool, 3> space;
+    std::vector<util::brick_grid<int>> voxels; // Which orientations of each part cover each voxel, one bit for each orientation
+    std::vector<std::vector<std::vector<column>>> footprints; // The non-empty columns of each orientation of each part
+    std::vector<int> volumes;
+
+    // With a clearance between parts, `voxels` and `footprints` only cover the parts themselves, and these cover everything
+    // within the clearance of them, reaching `margin` voxels further on every side. Placing a part takes up its clearance,
+    // so each part placed later only needs to test its own voxels against the space.
+    std::vector<util::brick_grid<int>> clearances;
+    std::vector<std::vector<std::vector<column>>> clearance_footprints;
+    int margin = 0;
+
+    std::vector<std::optional<std::pair<std::size_t, lattice>>> lattices; // The orientation and packing to tile with, for parts with many instances
     std::vector<std::shared_ptr<const part>> ordered_parts;
-    stack_result result;
     std::size_t total_parts;
-    std::size_t total_placed;
+    std::atomic<std::size_t> total_placed;
+};
+
+// Where one instance of a part was placed, and in which orientation
+struct placement {
+    int bit_index;
+    geo::point3<int> position;
 };
 
-void place(const util::mdspan<Bool, 3> space, const int index, const util::mdspan<const int, 3> obj, const int x, const int y, const int z) {
-    const int max_i = std::min(x + obj.extent(0), space.extent(0));
-    const int max_j = std::min(y + obj.extent(1), space.extent(1));
-    const int max_k = std::min(z + obj.extent(2), space.extent(2));
-    for (int i = x; i < max_i; ++i) {
-        for (int j = y; j < max_j; ++j) {
-            for (int k = z; k < max_k; ++k) {
+// `plate_state` is everything that belongs to a single build volume
+struct plate_state {
+    util::mdarray<Bool, 3> space;
+    stack_result result;
+    extreme_points candidates;
+    util::mdarray<int, 2> heights; // One above the highest occupied voxel of each column of the space
+    std::vector<std::size_t> quantities; // Instances of each part which still need to be placed on this plate
+    bool display;
+    bool parallel_growth = false; // Unless `batch_growth` is set and there are spare threads for a single plate, grow one instance at a time
+    bool trial = false; // Trial copies of a plate only record their `placements`, and neither build up the result nor report progress
+    std::vector<placement> placements;
+};
+
+// What placing an instance of the part takes up, starting `state.margin` voxels before where it is placed
+const util::brick_grid<int>& taken_voxels(const stack_state& state, const std::size_t part_index) {
+    return state.clearances.empty() ? state.voxels[part_index] : state.clearances[part_index];
+}
+
+const std::vector<std::vector<stack_state::column>>& taken_footprints(const stack_state& state, const std::size_t part_index) {
+    return state.clearances.empty() ? state.footprints[part_index] : state.clearance_footprints[part_index];
+}
+
+void place(const util::mdspan<Bool, 3> space, const int index, const util::brick_grid<int>& obj, const int x, const int y, const int z) {
+    const int max_i = std::min<int>(x + obj.extent(0), space.extent(0));
+    const int max_j = std::min<int>(y + obj.extent(1), space.extent(1));
+    const int max_k = std::min<int>(z + obj.extent(2), space.extent(2));
+    for (int i = std::max(x, 0); i < max_i; ++i) {
+        for (int j = std::max(y, 0); j < max_j; ++j) {
+            for (int k = std::max(z, 0); k < max_k; ++k) {
 #if defined(MDSPAN_USE_BRACKET_OPERATOR) and MDSPAN_USE_BRACKET_OPERATOR == 0
-                space(i, j, k) |= (obj(i - x, j - y, k - z) & index) != 0;
+                space(i, j, k) |= (obj.at(i - x, j - y, k - z) & index) != 0;
 #else
-                space[i, j, k] |= (obj[i - x, j - y, k - z] & index) != 0;
+                space[i, j, k] |= (obj.at(i - x, j - y, k - z) & index) != 0;
 #endif
             }
         }
     }
 }
 
-int can_place(const util::mdspan<const Bool, 3> space, int possible, const util::mdspan<const int, 3> obj, const std::size_t x, const std::size_t y, const std::size_t z) {
+std::vector<stack_state::column> footprint(const util::brick_grid<int>& obj, const int index) {
+    std::vector<stack_state::column> columns{};
+    for (int i = 0; i < obj.extent(0); ++i) {
+        for (int j = 0; j < obj.extent(1); ++j) {
+            int bottom = -1;
+            int top = -1;
+            for (int k = 0; k < obj.extent(2); ++k) {
+                if ((obj.at(i, j, k) & index) != 0) {
+                    if (bottom == -1) {
+                        bottom = k;
+                    }
+                    top = k;
+                }
+            }
+            if (bottom != -1) {
+                columns.push_back({ i, j, bottom, top });
+            }
+        }
+    }
+
+    // The columns which reach lowest usually decide where the part comes to rest, so check them first
+    std::ranges::sort(columns, {}, &stack_state::column::bottom);
+    return columns;
+}
+
+// The rotation as a matrix of integers, if it only swaps and flips the axes
+std::optional<geo::matrix3<int>> lattice_rotation(const geo::matrix3<float>& rotation) {
+    const auto snap = [](const float value, int& exact) {
+        exact = static_cast<int>(std::lround(value));
+        return std::abs(value - exact) < 1e-4f;
+    };
+    geo::matrix3<int> exact{};
+    if (snap(rotation.xx, exact.xx) and snap(rotation.xy, exact.xy) and snap(rotation.xz, exact.xz)
+        and snap(rotation.yx, exact.yx) and snap(rotation.yy, exact.yy) and snap(rotation.yz, exact.yz)
+        and snap(rotation.zx, exact.zx) and snap(rotation.zy, exact.zy) and snap(rotation.zz, exact.zz))
+    {
+        return exact;
+    }
+    return std::nullopt;
+}
+
+// The part is only looked up under occupied voxels of the space, so the sparse grid costs nothing where the space is empty
+int can_place(const util::mdspan<const Bool, 3> space, int possible, const util::brick_grid<int>& obj, const std::size_t x, const std::size_t y, const std::size_t z) {
     const std::size_t max_i = std::min(x + obj.extent(0), space.extent(0));
     const std::size_t max_j = std::min(y + obj.extent(1), space.extent(1));
     const std::size_t max_k = std::min(z + obj.extent(2), space.extent(2));
     for (std::size_t i = x; i < max_i; ++i) {
         for (std::size_t j = y; j < max_j; ++j) {
-            for (std::size_t k = z; k < max_k; ++k) {
 #if defined(MDSPAN_USE_BRACKET_OPERATOR) and MDSPAN_USE_BRACKET_OPERATOR == 0
-                if (space(i, j, k)) {
-                    possible &= (possible ^ obj(i - x, j - y, k - z));
+            const Bool* const row = &space(i, j, 0);
 #else
-                if (space[i, j, k]) {
-                    possible &= (possible ^ obj[i - x, j - y, k - z]);
+            const Bool* const row = &space[i, j, 0];
 #endif
+            for (std::size_t k = z; k < max_k; ++k) {
+                if (row[k]) {
+                    possible &= (possible ^ obj.at(i - x, j - y, k - z));
                     if (possible == 0) {
                         return 0;
                     }
@@ -78,7 +177,58 @@ int can_place(const util::mdspan<const Bool, 3> space, int possible, const util:
     return possible;
 }
 
-std::size_t try_place(const stack_parameters& params, stack_state& state, const std::size_t part_index, const std::size_t to_place, const geo::point3<int> max) {
+// Calculate which orientations fit in bounding box
+int fitting_orientations(const std::vector<stack_state::mesh_entry>& meshes, const int x, const int y, const int z, const geo::point3<int> max) {
+    int bit_index = 1;
+    int possible = 0;
+    for (const auto& [mesh, box_size, piece] : meshes) {
+        if (x + box_size.x < max.x && y + box_size.y < max.y && z + box_size.z < max.z) {
+            possible |= bit_index;
+        }
+        bit_index *= 2;
+    }
+    return possible;
+}
+
+// Place one instance of the part at (x, y, z), using the first of the orientations which are `possible`
+void commit(const stack_parameters& params, stack_state& state, plate_state& plate, const std::size_t part_index, const int possible, const int x, const int y, const int z, const geo::point3<int> max) {
+    int bit_index = 1;
+    for (std::size_t rotation = 0; rotation != state.meshes[part_index].size(); ++rotation, bit_index *= 2) {
+        if ((possible & bit_index) != 0) {
+            const auto& [mesh, box_size, piece] = state.meshes[part_index][rotation];
+            if (plate.trial) {
+                plate.placements.push_back({ bit_index, { x, y, z } });
+            } else {
+                const geo::vector3<float> translation = { (float)x, (float)y, (float)z };
+                plate.result.mesh.add(mesh, translation);
+                auto& new_piece = plate.result.pieces.emplace_back(piece);
+                new_piece.translation += translation;
+            }
+            place(plate.space, bit_index, taken_voxels(state, part_index), x - state.margin, y - state.margin, z - state.margin); // Mark voxels as occupied
+            // The box reaches past the part by its clearance, so that the next candidates are where another part can go right up against it
+            const geo::point3<int> low = { std::max(x - state.margin, 0), std::max(y - state.margin, 0), std::max(z - state.margin, 0) };
+            const geo::point3<int> high = { x + box_size.x + state.margin, y + box_size.y + state.margin, z + box_size.z + state.margin };
+            plate.candidates.add_box(low, high - low);
+            for (const auto& [i, j, bottom, top] : taken_footprints(state, part_index)[rotation]) {
+                const int column_x = x + i - state.margin;
+                const int column_y = y + j - state.margin;
+                if (column_x >= 0 && column_y >= 0 && column_x < plate.heights.extent(0) && column_y < plate.heights.extent(1)) {
+                    int& height = plate.heights[column_x, column_y];
+                    height = std::max(height, z + top - state.margin + 1);
+                }
+            }
+            if (not plate.trial) {
+                params.set_progress(++state.total_placed, state.total_parts);
+            }
+            if (plate.display) {
+                params.display_mesh(plate.result.mesh, max);
+            }
+            return;
+        }
+    }
+}
+
+std::size_t try_place_scan(const stack_parameters& params, stack_state& state, plate_state& plate, const std::size_t part_index, const std::size_t to_place, const geo::point3<int> max, const std::atomic<bool>& running) {
     std::size_t placed = 0;
     for (int s = 0; s <= max.x + max.y + max.z; ++s) {
         for (int r = std::max(0, s - max.z); r <= std::min(s, max.x + max.y); ++r) {
@@ -86,59 +236,369 @@ std::size_t try_place(const stack_parameters& params, stack_state& state, const
             for (int x = std::max(0, r - max.y); x <= std::min(r, max.x); ++x) {
                 const int y = r - x;
 
-                // Calculate which orientations fit in bounding box
+                int possible = fitting_orientations(state.meshes[part_index], x, y, z, max);
+                possible = can_place(plate.space, possible, state.voxels[part_index], x, y, z);
+
+                if (possible != 0) { // If it fits, place it and move to the next instance of the part
+                    commit(params, state, plate, part_index, possible, x, y, z, max);
+                    ++placed;
+                    if (to_place == placed or not running) { // All instances of this part placed, move to next part
+                        return placed;
+                    }
+                }
+            }
+        }
+    }
+
+    // Reached the end of the box, return the part we're currently at.
+    return placed;
+}
+
+std::size_t try_place_extreme_points(const stack_parameters& params, stack_state& state, plate_state& plate, const std::size_t part_index, const std::size_t to_place, const geo::point3<int> max, const std::atomic<bool>& running) {
+    std::size_t placed = 0;
+    while (placed != to_place and running) {
+        bool found = false;
+        for (const auto [x, y, z] : plate.candidates.points()) {
+            int possible = fitting_orientations(state.meshes[part_index], x, y, z, max);
+            if (possible != 0) {
+                possible = can_place(plate.space, possible, state.voxels[part_index], x, y, z);
+            }
+            if (possible != 0) {
+                commit(params, state, plate, part_index, possible, x, y, z, max); // Invalidates the points, so stop iterating
+                found = true;
+                break;
+            }
+        }
+
+        // None of the extreme points work, so fall back to the full scan for the remaining instances
+        if (not found) {
+            return placed + try_place_scan(params, state, plate, part_index, to_place - placed, max, running);
+        }
+        ++placed;
+    }
+    return placed;
+}
+
+// Drops each instance straight down onto the height map of the plate, and places it in the column where it comes to rest lowest.
+// Only space above the height map is considered, so cavities under overhangs are left to the full scan.
+std::size_t try_place_drop(const stack_parameters& params, stack_state& state, plate_state& plate, const std::size_t part_index, const std::size_t to_place, const geo::point3<int> max, const std::atomic<bool>& running) {
+    struct candidate {
+        int z;
+        int x;
+        int y;
+        int bit_index;
+    };
+    static constexpr std::size_t max_candidates = 8;
+
+    std::size_t placed = 0;
+    std::vector<candidate> best{};
+    while (placed != to_place and running) {
+        // Keep the lowest few resting positions, in case the height map is not the whole story.
+        // Positions are visited in scan order, so a later position only replaces a kept one if it rests strictly lower.
+        best.clear();
+        for (int s = 0; s <= max.x + max.y; ++s) {
+            for (int x = std::max(0, s - max.y); x <= std::min(s, max.x); ++x) {
+                const int y = s - x;
                 int bit_index = 1;
-                int possible = 0;
-                for (const auto& [mesh, box_size, piece] : state.meshes[part_index]) {
-                    if (x + box_size.x < max.x && y + box_size.y < max.y && z + box_size.z < max.z) {
-                        possible |= bit_index;
+                for (std::size_t rotation = 0; rotation != state.meshes[part_index].size(); ++rotation, bit_index *= 2) {
+                    const geo::vector3<int> box_size = state.meshes[part_index][rotation].box_size;
+                    if (x + box_size.x >= max.x or y + box_size.y >= max.y) {
+                        continue;
+                    }
+
+                    // The highest resting position which is still worth knowing about
+                    int limit = max.z - box_size.z - 1;
+                    if (best.size() == max_candidates) {
+                        limit = std::min(limit, best.back().z - 1);
+                    }
+
+                    int z = 0;
+                    for (const auto& [i, j, bottom, top] : state.footprints[part_index][rotation]) {
+                        z = std::max(z, plate.heights[x + i, y + j] - bottom);
+                        if (z > limit) {
+                            break;
+                        }
                     }
-                    bit_index *= 2;
+                    if (z > limit) {
+                        continue;
+                    }
+
+                    best.insert(std::ranges::upper_bound(best, z, {}, &candidate::z), { z, x, y, bit_index });
+                    if (best.size() > max_candidates) {
+                        best.pop_back();
+                    }
+                }
+            }
+        }
+
+        bool found = false;
+        for (const auto& [z, x, y, index] : best) {
+            if (can_place(plate.space, index, state.voxels[part_index], x, y, z) != 0) {
+                commit(params, state, plate, part_index, index, x, y, z, max);
+                found = true;
+                break;
+            }
+        }
+
+        // Nowhere left to drop, but the remaining instances may still fit underneath overhangs
+        if (not found) {
+            return placed + try_place_scan(params, state, plate, part_index, to_place - placed, max, running);
+        }
+        ++placed;
+    }
+    return placed;
+}
+
+// Places up to `to_place` instances of the part within `max`, and returns how many it placed.
+// Stops early once `running` is cleared.
+std::size_t try_place(const stack_parameters& params, stack_state& state, plate_state& plate, const std::size_t part_index, const std::size_t to_place, const geo::point3<int> max, const std::atomic<bool>& running) {
+    switch (params.settings.placement) {
+        case placement_mode::extreme_points: {
+            return try_place_extreme_points(params, state, plate, part_index, to_place, max, running);
+        }
+        case placement_mode::drop: {
+            return try_place_drop(params, state, plate, part_index, to_place, max, running);
+        }
+        case placement_mode::scan:
+        default: {
+            return try_place_scan(params, state, plate, part_index, to_place, max, running);
+        }
+    }
+}
+
+// Stamps out instances of the part along its lattice within the current x and y bounds, from the bottom layer up.
+// Positions which are already occupied are skipped, the z bound is raised to fit the layers which were used,
+// and the gaps around the edges are left for the normal placement to fill in. Stops early once `running` is cleared.
+std::size_t tile(const stack_parameters& params, stack_state& state, plate_state& plate, const std::size_t part_index, const std::size_t to_place, geo::point3<int>& max, const std::atomic<bool>& running) {
+    const auto& [rotation, basis] = *state.lattices[part_index];
+    const geo::vector3<int> box_size = state.meshes[part_index][rotation].box_size;
+    const int bit_index = 1 << rotation;
+    std::size_t placed = 0;
+    for (const auto [x, y, z] : basis.points(box_size, { max.x, max.y, (int)plate.space.extent(2) })) {
+        if (not running) {
+            break;
+        }
+        if (can_place(plate.space, bit_index, state.voxels[part_index], x, y, z) != 0) {
+            max.z = std::max(max.z, z + box_size.z + 2);
+            commit(params, state, plate, part_index, bit_index, x, y, z, max);
+            ++placed;
+            if (to_place == placed) {
+                break;
+            }
+        }
+    }
+    return placed;
+}
+
+// Finds the smallest enlargement of the plate's current bounds which fits one more instance of the part
+std::optional<geo::point3<int>> grow(const stack_state& state, const plate_state& plate, const std::size_t part_index, const int max_x, const int max_y, const int max_z) {
+    int best = std::numeric_limits<int>::max();
+    int new_x = plate.space.extent(0);
+    int new_y = plate.space.extent(1);
+    int new_z = plate.space.extent(2);
+    const geo::point3<int> space_size = { new_x, new_y, new_z };
+
+    int min_box_x = std::numeric_limits<int>::max();
+    int min_box_y = std::numeric_limits<int>::max();
+    int min_box_z = std::numeric_limits<int>::max();
+    for (const auto& [mesh, box_size, piece] : state.meshes[part_index]) {
+        min_box_x = std::min(box_size.x, min_box_x);
+        min_box_y = std::min(box_size.y, min_box_y);
+        min_box_z = std::min(box_size.z, min_box_z);
+    }
+
+    for (int s = 0; s < plate.space.extent(0) + plate.space.extent(1) + plate.space.extent(2) - min_box_x - min_box_y - min_box_z; ++s) {
+        for (int r = std::max<std::size_t>(0, s - plate.space.extent(2) - min_box_z); r <= std::min<std::size_t>(s, plate.space.extent(0) + plate.space.extent(1) - min_box_x - min_box_y); ++r) {
+            const int z = s - r;
+            if (std::max(z + min_box_z, max_z) * max_y * max_x > best) {
+                break;
+            }
+
+            for (int x = std::max<std::size_t>(0, r - plate.space.extent(1) - min_box_y); x <= std::min<std::size_t>(r, plate.space.extent(0) - min_box_z); ++x) {
+                const int y = r - x;
+                if (std::max(x + min_box_x, max_x) * std::max(y + min_box_y, max_y) * std::max(z + min_box_z, max_z) > best) {
+                    continue;
                 }
 
-                possible = can_place(state.space, possible, state.voxels[part_index], x, y, z);
+                int possible = fitting_orientations(state.meshes[part_index], x, y, z, space_size);
+                possible = can_place(plate.space, possible, state.voxels[part_index], x, y, z);
 
                 if (possible != 0) { // If it fits, figure out which rotation to use
-                    bit_index = 1;
+                    int bit_index = 1;
                     for (const auto& [mesh, box_size, piece] : state.meshes[part_index]) {
-                        if ((possible & bit_index) == 0) {
-                            bit_index *= 2;
-                            continue;
-                        } else {
-                            const geo::vector3<float> translation = { (float)x, (float)y, (float)z };
-                            state.result.mesh.add(mesh, translation);
-                            auto& new_piece = state.result.pieces.emplace_back(piece);
-                            new_piece.translation += translation;
-                            place(state.space, bit_index, state.voxels[part_index], x, y, z); // Mark voxels as occupied
-                            ++placed;
-                            ++state.total_placed;
-                            params.set_progress(state.total_placed, state.total_parts);
-                            params.display_mesh(state.result.mesh, max);
-                            if (to_place == placed) { // All instances of this part placed, move to next part
-                                return placed;
-                            } else { // Move to next instance of part
-                                break;
+                        if ((possible & bit_index) != 0) {
+                            const int new_box = std::max(max_x, x + box_size.x) * std::max(max_y, y + box_size.y) * std::max(max_z, z + box_size.z);
+                            if (new_box < best) {
+                                best = new_box;
+                                new_x = x + box_size.x;
+                                new_y = y + box_size.y;
+                                new_z = z + box_size.z;
                             }
                         }
+                        bit_index *= 2;
                     }
                 }
             }
         }
     }
 
-    // Reached the end of the box, return the part we're currently at.
-    return placed;
+    if (best == std::numeric_limits<int>::max()) {
+        return std::nullopt;
+    }
+    return geo::point3<int>{ new_x, new_y, new_z };
 }
 
-std::optional<stack_result> stack_impl(const stack_parameters& params, const std::atomic<bool>& running) {
+// Finds the smallest bounds between `min` and the size of the space which fit all `to_place` remaining instances of the part.
+// Each round places the whole batch onto copies of the space with several bounds in parallel, then narrows the search to between
+// the largest bounds which failed and the smallest which fit, assuming that larger bounds never fit fewer instances.
+// The copies only record where they placed each instance, and those of the winning bounds are placed again onto the plate itself.
+// Returns the winning bounds, or `std::nullopt` if the batch does not fit at all, if larger bounds turn out to fit fewer instances
+// after all, so that the search cannot be trusted, or if aborted. In each case the plate is left as it was.
+std::optional<geo::point3<int>> grow_batch(const stack_parameters& params, stack_state& state, plate_state& plate, const std::size_t part_index, const std::size_t to_place, const geo::point3<int> min, const std::atomic<bool>& running) {
+    const geo::point3<int> max = { (int)plate.space.extent(0), (int)plate.space.extent(1), (int)plate.space.extent(2) };
+    const int steps = std::max({ max.x - min.x, max.y - min.y, max.z - min.z, 0 });
+    const auto bounds = [&](const int step) {
+        return geo::point3<int>{
+            min.x + (max.x - min.x) * step / std::max(steps, 1),
+            min.y + (max.y - min.y) * step / std::max(steps, 1),
+            min.z + (max.z - min.z) * step / std::max(steps, 1),
+        };
+    };
+
+    const std::size_t trial_count = std::min<std::size_t>(util::thread_count(), 8);
+    std::optional<std::vector<placement>> winner{};
+    int fail = -1; // Largest step known not to fit
+    int fit = steps; // Smallest step which might fit, only known once `winner` is set
+    std::vector<int> trial_steps{};
+    std::vector<std::optional<std::vector<placement>>> trials{};
+    while (fit - fail > 1 or not winner.has_value()) {
+        // Until something fits, the whole space is one of the trials, after that only the steps in between are left
+        trial_steps.clear();
+        const std::size_t divisions = winner.has_value() ? trial_count + 1 : trial_count;
+        for (std::size_t t = 1; t <= trial_count; ++t) {
+            const int step = fail + static_cast<int>((fit - fail) * t / divisions);
+            if (step != fail and (trial_steps.empty() or trial_steps.back() != step)) {
+                trial_steps.push_back(step);
+            }
+        }
+
+        trials.assign(trial_steps.size(), std::nullopt);
+        util::parallel_for(trial_steps.size(), [&](const std::size_t t) {
+            plate_state trial{ .space = plate.space, .candidates = plate.candidates, .heights = plate.heights, .display = false, .parallel_growth = false, .trial = true };
+            if (try_place(params, state, trial, part_index, to_place, bounds(trial_steps[t]), running) == to_place) {
+                trials[t] = std::move(trial.placements);
+            }
+        });
+        if (not running) {
+            return std::nullopt;
+        }
+
+        const auto fits = [](const std::optional<std::vector<placement>>& trial) { return trial.has_value(); };
+        const auto smallest = std::ranges::find_if(trials, fits);
+        if (not std::all_of(smallest, trials.end(), fits)) {
+            return std::nullopt;
+        }
+        if (smallest == trials.end()) {
+            if (not winner.has_value()) { // Not even the whole space fits the batch
+                return std::nullopt;
+            }
+            fail = trial_steps.back();
+        } else {
+            const std::size_t t = smallest - trials.begin();
+            fail = t == 0 ? fail : trial_steps[t - 1];
+            fit = trial_steps[t];
+            winner = std::move(*smallest);
+        }
+    }
+
+    for (const auto& [bit_index, position] : *winner) {
+        commit(params, state, plate, part_index, bit_index, position.x, position.y, position.z, bounds(fit));
+    }
+    return bounds(fit);
+}
+
+// Places `plate.quantities` onto the plate, growing its bounds from the initial size up to the maximum size.
+// If `overflow` is set, instances which cannot fit are left in `plate.quantities` for another plate, otherwise the plate fails.
+// Returns `std::nullopt` when aborted, or whether every instance was placed or left as overflow.
+std::optional<bool> stack_plate(const stack_parameters& params, stack_state& state, plate_state& plate, const bool overflow, const std::atomic<bool>& running) {
+    const double scale_factor = 1 / params.settings.resolution;
+    int max_x = static_cast<int>(scale_factor * params.settings.x_min);
+    int max_y = static_cast<int>(scale_factor * params.settings.y_min);
+    int max_z = static_cast<int>(scale_factor * params.settings.z_min);
+    plate.space = {
+        std::max(max_x, static_cast<int>(scale_factor * params.settings.x_max)),
+        std::max(max_y, static_cast<int>(scale_factor * params.settings.y_max)),
+        std::max(max_z, static_cast<int>(scale_factor * params.settings.z_max))
+    };
+    plate.heights = { plate.space.extent(0), plate.space.extent(1) };
+
+    for (std::size_t part_index = 0; part_index != state.ordered_parts.size(); ++part_index) {
+        std::size_t& to_place = plate.quantities[part_index];
+        if (state.lattices[part_index].has_value() and to_place >= lattice_quantity) {
+            geo::point3<int> max = { max_x, max_y, max_z };
+            to_place -= tile(params, state, plate, part_index, to_place, max, running);
+            max_z = max.z;
+        }
+
+        while (to_place > 0) {
+            if (not running) {
+                return std::nullopt;
+            }
+            const std::size_t placed = try_place(params, state, plate, part_index, to_place, { max_x, max_y, max_z }, running);
+            to_place -= placed;
+
+            // If we have not placed a part, it means there are no more ways to place an instance of the current part in the box: it must be enlarged
+            if (placed == 0) {
+                const std::optional<geo::point3<int>> new_max = grow(state, plate, part_index, max_x, max_y, max_z);
+                if (not new_max.has_value()) {
+                    if (overflow) { // Leave the remaining instances of this part for the next plate
+                        break;
+                    }
+                    return false;
+                }
+
+                max_x = std::max(max_x, new_max->x + 2);
+                max_y = std::max(max_y, new_max->y + 2);
+                max_z = std::max(max_z, new_max->z + 2);
+
+                // Rather than growing one instance at a time, jump straight to bounds which fit every remaining instance
+                if (plate.parallel_growth and to_place > 1) {
+                    const std::optional<geo::point3<int>> batch_max = grow_batch(params, state, plate, part_index, to_place, { max_x, max_y, max_z }, running);
+                    if (batch_max.has_value()) {
+                        max_x = batch_max->x;
+                        max_y = batch_max->y;
+                        max_z = batch_max->z;
+                        to_place = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    plate.space = {};
+    plate.heights = {};
+    plate.result.mesh.scale(1 / scale_factor);
+    return true;
+}
+
+std::optional<std::vector<stack_result>> stack_impl(const stack_parameters& params, const std::atomic<bool>& running) {
     stack_state state{};
     state.ordered_parts = params.parts;
     std::ranges::sort(state.ordered_parts, std::greater{}, &part::volume);
     state.meshes.assign(state.ordered_parts.size(), {});
     state.voxels.assign(state.ordered_parts.size(), {});
+    state.footprints.assign(state.ordered_parts.size(), {});
+    state.lattices.assign(state.ordered_parts.size(), std::nullopt);
+    state.volumes.assign(state.ordered_parts.size(), 0);
 
     double triangles = 0;
     const double scale_factor = 1 / params.settings.resolution;
+    const double gap = params.settings.clearance * scale_factor;
+    if (gap > 0) {
+        state.clearances.assign(state.ordered_parts.size(), {});
+        state.clearance_footprints.assign(state.ordered_parts.size(), {});
+        state.margin = clearance_margin(gap);
+    }
     state.total_parts = 0;
     state.total_placed = 0;
     for (const std::shared_ptr<const part> part : state.ordered_parts) {
@@ -150,185 +610,277 @@ std::optional<stack_result> stack_impl(const stack_parameters& params, const std
     for (int i = 0; i < state.ordered_parts.size(); ++i) {
         geo::matrix3 base_rotation = geo::eye3<float>;
 
-        if (state.ordered_parts[i]->rotate_min_box) {
-            auto reduced_view = state.ordered_parts[i]->mesh.triangles()
-                              | std::views::filter([i = 0](auto&&) mutable { return i++ % 16 == 0; });
-            mesh reduced_mesh{ std::vector<geo::triangle>(reduced_view.begin(), reduced_view.end()) };
-
-            static constexpr std::size_t sections = 20;
-            static constexpr double angle_diff = 2 * geo::pi / sections;
-
-            static constexpr geo::matrix3 rot_x = geo::rot3_x<float>(geo::radians{angle_diff});
-            static constexpr geo::matrix3 rot_y = geo::rot3_y<float>(geo::radians{angle_diff});
-
-            int min_box_volume = std::numeric_limits<int>::max();
-            double best_x = 0;
-            double best_y = 0;
-
-            for (double x = 0; x < 2 * geo::pi; x += angle_diff) {
-                reduced_mesh.rotate(rot_x);
-                for (double y = 0; y < 2 * geo::pi; y += angle_diff) {
-                    reduced_mesh.rotate(rot_y);
-                    const auto box = reduced_mesh.bounding().box_size;
-                    const int box_volume = box.x * box.y * box.z;
-                    if (box_volume < min_box_volume) {
-                        min_box_volume = box_volume;
-                        best_x = x;
-                        best_y = y;
-                    }
-                }
+        // Room for every orientation of the part, and for its clearance around them
+        const auto allocate_voxels = [&](const geo::vector3<int> size) {
+            state.voxels[i] = { size.x, size.y, size.z };
+            if (not state.clearances.empty()) {
+                state.clearances[i] = { size.x + 2 * state.margin, size.y + 2 * state.margin, size.z + 2 * state.margin };
+            }
+        };
+        // Adds one orientation from the voxels it covers, and returns its volume.
+        // Without a clearance, the part takes up its voxels expanded by one, and tests those same voxels when placed.
+        const auto add_orientation = [&](const util::mdspan<const Bool, 3> solid, const int bit_index) {
+            if (state.clearances.empty()) {
+                const int volume = dilate(solid, state.voxels[i], bit_index);
+                state.footprints[i].push_back(footprint(state.voxels[i], bit_index));
+                return volume;
             }
+            dilate(solid, state.clearances[i], bit_index, gap);
+            state.clearance_footprints[i].push_back(footprint(state.clearances[i], bit_index));
+            const int volume = mark(solid, state.voxels[i], bit_index);
+            state.footprints[i].push_back(footprint(state.voxels[i], bit_index));
+            return volume;
+        };
 
-            base_rotation = geo::rot3_y<float>(geo::radians{best_y}) * geo::rot3_x<float>(geo::radians{best_x});
+        if (state.ordered_parts[i]->rotate_min_box) {
+            const std::optional<geo::matrix3<float>>& min_box = state.ordered_parts[i]->min_box_rotation;
+            base_rotation = min_box.has_value() ? *min_box : min_box_rotation(state.ordered_parts[i]->mesh);
         }
 
         // Set up array of parts
         const auto rotations = rotation_sets[state.ordered_parts[i]->rotation_index];
         state.meshes[i].reserve(rotations.size());
 
-        // Track bounding box size
-        geo::vector3<int> max_box_size = { 1, 1, 1 };
-
-        // Calculate all the rotations
+        // Rotations which only swap and flip the axes map every voxel exactly onto another,
+        // so the part is only voxelized once, and the other orientations are rotated from those voxels
+        std::vector<geo::matrix3<int>> exact_rotations{};
         for (const auto& rotation : rotations) {
-            if (not running) {
-                return std::nullopt;
+            if (const auto exact = lattice_rotation(rotation)) {
+                exact_rotations.push_back(*exact);
             }
+        }
 
+        if (exact_rotations.size() == rotations.size()) {
             const std::shared_ptr<const part> part = state.ordered_parts[i];
-            mesh m = part->mesh;
-            m.scale(scale_factor);
-            auto total_rotation = base_rotation * rotation;
-            m.rotate(total_rotation);
-            auto offset = m.set_baseline({ 0, 0, 0 });
-
-            const auto box_size = m.bounding().box_size;
-            max_box_size.x = std::max(box_size.x, max_box_size.x);
-            max_box_size.y = std::max(box_size.y, max_box_size.y);
-            max_box_size.z = std::max(box_size.z, max_box_size.z);
-
-            stack_result::piece piece = { .part = part, .rotation = total_rotation, .translation = offset };
+            mesh base{};
+            const mesh::transformed_t base_transformed = part->mesh.transform_into(base, scale_factor, base_rotation, { 0, 0, 0 });
+            const geo::vector3<float> base_offset = base_transformed.offset;
+            const geo::vector3<int> base_size = base_transformed.bounding.box_size;
+            util::mdarray<Bool, 3> solid(base_size.x, base_size.y, base_size.z);
+            voxelize_solid(base, solid, part->min_hole, params.settings.fill);
+
+            geo::vector3<int> max_box_size = { 1, 1, 1 };
+            for (const geo::matrix3<int>& exact : exact_rotations) {
+                const geo::vector3<int> turned = exact * base_size;
+                max_box_size.x = std::max(std::abs(turned.x), max_box_size.x);
+                max_box_size.y = std::max(std::abs(turned.y), max_box_size.y);
+                max_box_size.z = std::max(std::abs(turned.z), max_box_size.z);
+            }
+            allocate_voxels(max_box_size);
+
+            util::mdarray<Bool, 3> rotated{};
+            int bit_index = 1;
+            for (const geo::matrix3<int>& exact : exact_rotations) {
+                if (not running) {
+                    return std::nullopt;
+                }
+
+                rotated.assign(state.voxels[i].extents(), false);
+                const geo::vector3<int> shift = rotate_solid(solid, rotated, exact);
+                const int volume = add_orientation(rotated, bit_index);
+                if (bit_index == 1) {
+                    state.volumes[i] = volume;
+                }
+                bit_index *= 2;
+
+                const geo::matrix3<float> rotation = { (float)exact.xx, (float)exact.xy, (float)exact.xz,
+                                                       (float)exact.yx, (float)exact.yy, (float)exact.yz,
+                                                       (float)exact.zx, (float)exact.zy, (float)exact.zz };
+                const geo::vector3<float> shift_f = { (float)shift.x, (float)shift.y, (float)shift.z };
+                mesh m = base;
+                m.rotate(rotation);
+                m.set_baseline(m.bounding().min + shift_f);
+
+                const geo::vector3<int> turned = exact * base_size;
+                const geo::vector3<int> box_size = { std::abs(turned.x), std::abs(turned.y), std::abs(turned.z) };
+                stack_result::piece piece = { .part = part, .rotation = rotation * base_rotation, .translation = rotation * base_offset + shift_f };
 #if defined(__cpp_aggregate_paren_init) and __cpp_aggregate_paren_init >= 201902L
-            state.meshes[i].emplace_back(std::move(m), box_size, std::move(piece));
+                state.meshes[i].emplace_back(std::move(m), box_size, std::move(piece));
 #else
-            state.meshes[i].push_back(stack_state::mesh_entry{std::move(m), box_size, std::move(piece)});
+                state.meshes[i].push_back(stack_state::mesh_entry{std::move(m), box_size, std::move(piece)});
 #endif
 
-            progress += part->triangle_count / 2;
-            params.set_progress(progress, triangles);
-        }
+                progress += part->triangle_count;
+                params.set_progress(progress, triangles);
+            }
+        } else {
+            const bool resample = params.settings.resample_rotations;
 
-        // Initialize space size to appropriate dimensions
-        state.voxels[i] = { max_box_size.x, max_box_size.y, max_box_size.z };
+            // Track bounding box size
+            geo::vector3<int> max_box_size = { 1, 1, 1 };
 
-        // Voxelize each rotated instance of this part
-        int bit_index = 1;
-        for (const auto& [mesh, box_size, piece] : state.meshes[i]) {
-            if (not running) {
-                return std::nullopt;
-            }
+            // Calculate all the rotations
+            for (const auto& rotation : rotations) {
+                if (not running) {
+                    return std::nullopt;
+                }
 
-            voxelize(mesh, state.voxels[i], bit_index, state.ordered_parts[i]->min_hole);
-            bit_index *= 2;
+                const std::shared_ptr<const part> part = state.ordered_parts[i];
+                mesh m{};
+                auto total_rotation = base_rotation * rotation;
+                const mesh::transformed_t transformed = part->mesh.transform_into(m, scale_factor, total_rotation, { 0, 0, 0 });
+                const geo::vector3<float> offset = transformed.offset;
 
-            progress += state.ordered_parts[i]->triangle_count / 2;
-            params.set_progress(progress, triangles);
-        }
-    }
+                // Resampled voxels can reach one voxel further than the mesh itself, so leave room for them
+                const geo::vector3<int> box_size = transformed.bounding.box_size + (resample ? geo::vector3<int>{ 1, 1, 1 } : geo::vector3<int>{});
+                max_box_size.x = std::max(box_size.x, max_box_size.x);
+                max_box_size.y = std::max(box_size.y, max_box_size.y);
+                max_box_size.z = std::max(box_size.z, max_box_size.z);
 
-    int max_x = static_cast<int>(scale_factor * params.settings.x_min);
-    int max_y = static_cast<int>(scale_factor * params.settings.y_min);
-    int max_z = static_cast<int>(scale_factor * params.settings.z_min);
-    state.space = {
-        std::max(max_x, static_cast<int>(scale_factor * params.settings.x_max)),
-        std::max(max_y, static_cast<int>(scale_factor * params.settings.y_max)),
-        std::max(max_z, static_cast<int>(scale_factor * params.settings.z_max))
-    };
+                stack_result::piece piece = { .part = part, .rotation = total_rotation, .translation = offset };
+#if defined(__cpp_aggregate_paren_init) and __cpp_aggregate_paren_init >= 201902L
+                state.meshes[i].emplace_back(std::move(m), box_size, std::move(piece));
+#else
+                state.meshes[i].push_back(stack_state::mesh_entry{std::move(m), box_size, std::move(piece)});
+#endif
 
-    params.set_progress(0, 1);
+                progress += part->triangle_count / 2;
+                params.set_progress(progress, triangles);
+            }
 
-    for (std::size_t part_index = 0; part_index != state.ordered_parts.size(); ++part_index) {
-        std::size_t to_place = state.ordered_parts[part_index]->quantity;
-        while (to_place > 0) {
-            if (not running) {
-                return std::nullopt;
+            // Initialize space size to appropriate dimensions
+            allocate_voxels(max_box_size);
+
+            // Either voxelize the part once on a finer grid and resample that for every orientation,
+            // which no longer depends on the number of triangles, or voxelize each rotated instance of this part.
+            // Only the resampler is kept throughout, and each orientation is added as soon as it is ready, so that only one is held at a time.
+            std::optional<resampler> sampler{};
+            geo::vector3<float> fine_offset{};
+            if (resample) {
+                mesh fine_mesh{};
+                const mesh::transformed_t fine_transformed = state.ordered_parts[i]->mesh.transform_into(fine_mesh, scale_factor * resample_factor, geo::eye3<float>, { 0, 0, 0 });
+                fine_offset = fine_transformed.offset;
+                const geo::vector3<int> fine_size = fine_transformed.bounding.box_size;
+                util::mdarray<Bool, 3> fine(fine_size.x, fine_size.y, fine_size.z);
+                voxelize_solid(fine_mesh, fine, state.ordered_parts[i]->min_hole * resample_factor, params.settings.fill);
+                sampler.emplace(fine, resample_factor);
             }
-            const std::size_t placed = try_place(params, state, part_index, to_place, { max_x, max_y, max_z });
-            to_place -= placed;
 
-            // If we have not placed a part, it means there are no more ways to place an instance of the current part in the box: it must be enlarged
-            if (placed == 0) {
-                int best = std::numeric_limits<int>::max();
-                int new_x = state.space.extent(0);
-                int new_y = state.space.extent(1);
-                int new_z = state.space.extent(2);
-
-                int min_box_x = std::numeric_limits<int>::max();
-                int min_box_y = std::numeric_limits<int>::max();
-                int min_box_z = std::numeric_limits<int>::max();
-                for (const auto& [mesh, box_size, piece] : state.meshes[part_index]) {
-                    min_box_x = std::min(box_size.x, min_box_x);
-                    min_box_y = std::min(box_size.y, min_box_y);
-                    min_box_z = std::min(box_size.z, min_box_z);
+            util::mdarray<Bool, 3> solid{};
+            int bit_index = 1;
+            for (std::size_t rotation = 0; rotation != state.meshes[i].size(); ++rotation) {
+                if (not running) {
+                    return std::nullopt;
                 }
 
-                for (int s = 0; s < state.space.extent(0) + state.space.extent(1) + state.space.extent(2) - min_box_x - min_box_y - min_box_z; ++s) {
-                    for (int r = std::max<std::size_t>(0, s - state.space.extent(2) - min_box_z); r <= std::min<std::size_t>(s, state.space.extent(0) + state.space.extent(1) - min_box_x - min_box_y); ++r) {
-                        const int z = s - r;
-                        if (std::max(z + min_box_z, max_z) * max_y * max_x > best) {
-                            break;
-                        }
-
-                        for (int x = std::max<std::size_t>(0, r - state.space.extent(1) - min_box_y); x <= std::min<std::size_t>(r, state.space.extent(0) - min_box_z); ++x) {
-                            const int y = r - x;
-                            if (std::max(x + min_box_x, max_x) * std::max(y + min_box_y, max_y) * std::max(z + min_box_z, max_z) > best) {
-                                continue;
-                            }
+                if (resample) {
+                    const stack_result::piece& piece = state.meshes[i][rotation].piece;
+                    solid.assign(state.voxels[i].extents(), false);
+                    sampler->resample(piece.rotation, piece.translation - piece.rotation * fine_offset / (float)resample_factor, solid);
+                } else {
+                    solid.resize(state.voxels[i].extents());
+                    voxelize_solid(state.meshes[i][rotation].mesh, solid, state.ordered_parts[i]->min_hole, params.settings.fill);
+                }
+                const int volume = add_orientation(solid, bit_index);
+                if (bit_index == 1) {
+                    state.volumes[i] = volume;
+                }
+                bit_index *= 2;
 
-                            // Calculate which orientations fit in bounding box
-                            int bit_index = 1;
-                            int possible = 0;
-                            for (const auto& [mesh, box_size, piece] : state.meshes[part_index]) {
-                                if (x + box_size.x < state.space.extent(0) && y + box_size.y < state.space.extent(1) && z + box_size.z < state.space.extent(2)) {
-                                    possible |= bit_index;
-                                }
-                                bit_index *= 2;
-                            }
+                progress += state.ordered_parts[i]->triangle_count / 2;
+                params.set_progress(progress, triangles);
+            }
+        }
 
-                            possible = can_place(state.space, possible, state.voxels[part_index], x, y, z);
-
-                            if (possible != 0) { // If it fits, figure out which rotation to use
-                                bit_index = 1;
-                                for (const auto& [mesh, box_size, piece] : state.meshes[part_index]) {
-                                    if ((possible & bit_index) != 0) {
-                                        const int new_box = std::max(max_x, x + box_size.x) * std::max(max_y, y + box_size.y) * std::max(max_z, z + box_size.z);
-                                        if (new_box < best) {
-                                            best = new_box;
-                                            new_x = x + box_size.x;
-                                            new_y = y + box_size.y;
-                                            new_z = z + box_size.z;
-                                        }
-                                    }
-                                    bit_index *= 2;
-                                }
-                            }
-                        }
-                    }
+        // Find the orientation which tiles most tightly, as long as that beats stacking up bounding boxes.
+        // Each search builds a table of every offset between two copies, so they are run one at a time, and only one table is ever held.
+        if (params.settings.tile_lattices and state.ordered_parts[i]->quantity >= lattice_quantity) {
+            for (std::size_t rotation = 0; rotation != state.meshes[i].size(); ++rotation) {
+                if (not running) {
+                    return std::nullopt;
                 }
-
-                if (best == std::numeric_limits<int>::max()) {
-                    return stack_result{};
+                const std::optional<lattice> found = find_lattice(state.voxels[i], taken_voxels(state, i), state.margin, 1 << rotation, running);
+                if (not found.has_value()) {
+                    return std::nullopt;
                 }
+                const geo::vector3<int> box_size = state.meshes[i][rotation].box_size;
+                const int best_volume = state.lattices[i].has_value() ? state.lattices[i]->second.cell_volume() : box_size.x * box_size.y * box_size.z;
+                if (found->cell_volume() < best_volume) {
+                    state.lattices[i].emplace(rotation, *found);
+                }
+            }
+        }
+    }
 
-                max_x = std::max(max_x, new_x + 2);
-                max_y = std::max(max_y, new_y + 2);
-                max_z = std::max(max_z, new_z + 2);
+    params.set_progress(0, 1);
+
+    std::vector<std::size_t> remaining{};
+    for (const std::shared_ptr<const part>& part : state.ordered_parts) {
+        remaining.push_back(part->quantity);
+    }
+
+    // Jumping to bounds which fit a whole batch can pack differently from growing one instance at a time, so it is only used when asked for
+    const bool batch_growth = params.settings.batch_growth and util::thread_count() > 1;
+    if (not params.settings.multiple_plates) {
+        plate_state plate{ .quantities = std::move(remaining), .display = true, .parallel_growth = batch_growth };
+        const std::optional<bool> stacked = stack_plate(params, state, plate, false, running);
+        if (not stacked.has_value()) {
+            return std::nullopt;
+        } else if (not *stacked) {
+            return std::vector<stack_result>{};
+        }
+        return std::vector{ std::move(plate.result) };
+    }
+
+    const double plate_volume = std::pow(scale_factor, 3)
+                              * std::max(params.settings.x_min, params.settings.x_max)
+                              * std::max(params.settings.y_min, params.settings.y_max)
+                              * std::max(params.settings.z_min, params.settings.z_max);
+
+    std::vector<stack_result> results{};
+    while (std::ranges::any_of(remaining, [](const std::size_t quantity) { return quantity != 0; })) {
+        // The voxel volume gives a lower bound on the number of plates needed for what remains.
+        // Plates in the same round do not depend on each other, so they are filled in parallel,
+        // and whatever overflows from any of them is carried over to the next round.
+        double remaining_volume = 0;
+        std::size_t remaining_instances = 0;
+        for (std::size_t i = 0; i != remaining.size(); ++i) {
+            remaining_volume += static_cast<double>(remaining[i]) * state.volumes[i];
+            remaining_instances += remaining[i];
+        }
+        const std::size_t plate_count = std::clamp<std::size_t>(static_cast<std::size_t>(std::ceil(remaining_volume / plate_volume)), 1, remaining_instances);
+
+        // Deal out the instances one at a time, so that every plate gets a similar mix of large and small parts
+        std::vector<plate_state> plates(plate_count);
+        for (plate_state& plate : plates) {
+            plate.quantities.assign(remaining.size(), 0);
+            plate.display = (&plate == &plates.front());
+            plate.parallel_growth = (plate_count == 1 and batch_growth);
+        }
+        std::size_t next_plate = 0;
+        for (std::size_t i = 0; i != remaining.size(); ++i) {
+            for (; remaining[i] != 0; --remaining[i]) {
+                ++plates[next_plate].quantities[i];
+                next_plate = (next_plate + 1) % plate_count;
+            }
+        }
+
+        std::vector<std::optional<bool>> stacked(plate_count);
+        util::parallel_for(plate_count, [&](const std::size_t p) {
+            stacked[p] = stack_plate(params, state, plates[p], true, running);
+        });
+        if (std::ranges::any_of(stacked, [](const std::optional<bool>& s) { return not s.has_value(); })) {
+            return std::nullopt;
+        }
+
+        bool any_placed = false;
+        for (plate_state& plate : plates) {
+            for (std::size_t i = 0; i != remaining.size(); ++i) {
+                remaining[i] += plate.quantities[i];
             }
+            if (not plate.result.pieces.empty()) {
+                any_placed = true;
+                results.push_back(std::move(plate.result));
+            }
+        }
+
+        // Nothing fits even on an empty plate, so the remaining parts can never be stacked
+        if (not any_placed) {
+            return std::vector<stack_result>{};
         }
     }
 
-    state.result.mesh.scale(1 / scale_factor);
-    return { std::move(state.result) };
+    return results;
 }
 
 } // namespace
@@ -338,13 +890,14 @@ void stacker::stack(const stack_parameters params) {
         return;
     }
     const auto start = std::chrono::system_clock::now();
-    std::optional<stack_result> result = stack_impl(params, _running);
+    std::optional<std::vector<stack_result>> results = stack_impl(params, _running);
+    release_scratch_grids(); // The calling thread may outlive the stacking
     const auto elapsed = std::chrono::system_clock::now() - start;
-    if (result.has_value()) {
-        if (result->pieces.empty()) {
+    if (results.has_value()) {
+        if (results->empty()) {
             params.on_failure();
         } else {
-            params.on_success(std::move(*result), elapsed);
+            params.on_success(std::move(*results), elapsed);
         }
     }
     params.on_finish();
@@ -3,6 +3,7 @@
 
 #include "pstack/calc/part.hpp"
 #include "pstack/calc/sinterbox.hpp"
+#include "pstack/calc/voxelize.hpp"
 #include "pstack/geo/vector3.hpp"
 #include <atomic>
 #include <chrono>
@@ -33,6 +34,13 @@ struct stack_result : stack_result_base<std::shared_ptr<const part>, sinterbox_p
     void reload_mesh();
 };
 
+// How candidate positions for each piece are searched
+enum class placement_mode {
+    scan,           // Every voxel, diagonal by diagonal from the origin
+    extreme_points, // Only the corners left by pieces already placed, falling back to the full scan
+    drop,           // Straight down onto the height map of pieces already placed, falling back to the full scan
+};
+
 struct stack_settings {
     double resolution = 1.0;
     int x_min = 150;
@@ -41,6 +49,13 @@ struct stack_settings {
     int y_max = 156;
     int z_min = 30;
     int z_max = 90;
+    bool multiple_plates = false;
+    placement_mode placement = placement_mode::scan;
+    fill_mode fill = fill_mode::convex;
+    bool resample_rotations = false;
+    double clearance = 0; // Kept exactly between parts, or one voxel when 0
+    bool batch_growth = false; // Grow the bounds for all remaining instances of a part at once, trying several sizes in parallel
+    bool tile_lattices = false; // Stamp out parts with many instances along their tightest lattice before placing the rest
 };
 
 struct stack_parameters {
@@ -49,7 +64,7 @@ struct stack_parameters {
 
     std::function<void(double, double)> set_progress;
     std::function<void(const mesh&, const geo::point3<int>)> display_mesh;
-    std::function<void(stack_result, std::chrono::system_clock::duration)> on_success;
+    std::function<void(std::vector<stack_result>, std::chrono::system_clock::duration)> on_success;
     std::function<void()> on_failure;
     std::function<void()> on_finish;
 };
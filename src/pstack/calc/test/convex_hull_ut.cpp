@@ -0,0 +1,113 @@
+#include "pstack/calc/convex_hull.hpp"
+#include "pstack/calc/test/shapes.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <array>
+#include <cmath>
+#include <map>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace pstack::calc {
+namespace {
+
+std::vector<geo::point3<float>> points_of(const mesh& m) {
+    std::vector<geo::point3<float>> out{};
+    for (std::uint32_t index = 0; index != m.vertices().size(); ++index) {
+        out.push_back(m.vertex(index));
+    }
+    return out;
+}
+
+// How many of the points lie further than `tolerance` outside any face of the hull
+int outside(const mesh& hull, const std::vector<geo::point3<float>>& points, const float tolerance) {
+    int out = 0;
+    for (const geo::point3<float> p : points) {
+        for (std::size_t index = 0; index != hull.triangle_count(); ++index) {
+            const geo::triangle t = hull.triangle(index);
+            const geo::vector3<float> normal = geo::cross(t.v2 - t.v1, t.v3 - t.v1);
+            if (geo::dot(normal, p - t.v1) > tolerance * std::sqrt(geo::dot(normal, normal))) {
+                ++out;
+                break;
+            }
+        }
+    }
+    return out;
+}
+
+// Whether every edge of the mesh is shared by exactly two triangles, going opposite ways along it
+bool closed(const mesh& m) {
+    std::map<std::pair<std::uint32_t, std::uint32_t>, int> edges{};
+    const std::vector<std::uint32_t>& indices = m.indices();
+    for (std::size_t i = 0; i != indices.size(); i += 3) {
+        for (std::size_t j = 0; j != 3; ++j) {
+            ++edges[{ indices[i + j], indices[i + (j + 1) % 3] }];
+        }
+    }
+    for (const auto& [edge, count] : edges) {
+        if (count != 1 or not edges.contains({ edge.second, edge.first })) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("convex shapes", "[convex_hull]") {
+    // A convex mesh is its own hull
+    for (const mesh& shape : { test::box({ 0, 0, 0 }, { 3, 5, 7 }), test::sphere({ 1, 2, 3 }, 4) }) {
+        const mesh hull = convex_hull(shape);
+        CHECK(hull.vertices().size() == shape.vertices().size());
+        CHECK(closed(hull));
+        CHECK(outside(hull, points_of(shape), 1e-4f) == 0);
+        const double volume = shape.volume_and_centroid().volume;
+        CHECK(std::abs(hull.volume_and_centroid().volume - volume) < 1e-4 * volume);
+    }
+}
+
+TEST_CASE("contains every vertex", "[convex_hull]") {
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> coordinate(-10, 10);
+    for (const int count : { 4, 20, 500 }) {
+        // Scattered corners, in triangles which are not meant to make any sense as a surface
+        std::vector<geo::triangle> triangles{};
+        for (int i = 0; i != count; ++i) {
+            const auto corner = [&] { return geo::point3<float>{ coordinate(random), coordinate(random), coordinate(random) }; };
+            triangles.push_back(test::make_triangle(corner(), corner(), corner()));
+        }
+        const mesh m(triangles);
+        const std::vector<geo::point3<float>> points = points_of(m);
+        const mesh hull = convex_hull(m);
+        CHECK(hull.triangle_count() >= 4);
+        CHECK(closed(hull));
+        CHECK(hull.volume_and_centroid().volume > 0);
+        CHECK(outside(hull, points, 1e-3f) == 0);
+
+        // Made of the vertices of the mesh, and facing outwards
+        std::set<std::array<float, 3>> originals{};
+        for (const geo::point3<float> p : points) {
+            originals.insert({ p.x, p.y, p.z });
+        }
+        for (const geo::point3<float> p : points_of(hull)) {
+            CHECK(originals.contains({ p.x, p.y, p.z }));
+        }
+        for (std::size_t index = 0; index != hull.triangle_count(); ++index) {
+            const geo::triangle t = hull.triangle(index);
+            CHECK(geo::dot(t.normal, geo::cross(t.v2 - t.v1, t.v3 - t.v1)) > 0);
+        }
+    }
+}
+
+TEST_CASE("flat meshes", "[convex_hull]") {
+    const mesh flat(std::vector<geo::triangle>{
+        test::make_triangle({ 0, 0, 1 }, { 4, 0, 1 }, { 4, 3, 1 }),
+        test::make_triangle({ 0, 0, 1 }, { 4, 3, 1 }, { 0, 3, 1 }),
+    });
+    const mesh hull = convex_hull(flat);
+    CHECK(hull.triangle_count() == flat.triangle_count());
+    CHECK(hull.indices() == flat.indices());
+    CHECK(convex_hull(mesh{}).triangle_count() == 0);
+}
+
+} // namespace
+} // namespace pstack::calc
@@ -0,0 +1,105 @@
+#include "pstack/calc/lattice.hpp"
+#include "pstack/calc/test/shapes.hpp"
+#include "pstack/calc/voxelize.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+namespace pstack::calc {
+namespace {
+
+struct voxelized {
+    util::brick_grid<int> voxels;
+    util::brick_grid<int> taken;
+    int margin;
+};
+
+// The voxels of the part and what placing it takes up, as the stacker works them out with and without a clearance
+voxelized voxelize_part(mesh m, const double gap) {
+    m.set_baseline({ 0, 0, 0 });
+    const geo::vector3<int> size = m.bounding().box_size;
+    util::mdarray<Bool, 3> solid(size.x, size.y, size.z);
+    voxelize_solid(m, solid, 1, fill_mode::convex);
+    voxelized out{ { size.x, size.y, size.z }, {}, 0 };
+    if (gap == 0) {
+        dilate(solid, out.voxels, 1);
+        out.taken = out.voxels;
+    } else {
+        out.margin = clearance_margin(gap);
+        out.taken = { size.x + 2 * out.margin, size.y + 2 * out.margin, size.z + 2 * out.margin };
+        mark(solid, out.voxels, 1);
+        dilate(solid, out.taken, 1, gap);
+    }
+    return out;
+}
+
+TEST_CASE("copies never overlap", "[lattice]") {
+    for (const double gap : { 0.0, 2.5 }) {
+        // Neither shape needs turning to nest into copies of itself
+        for (const mesh& shape : { test::sphere({ 0, 0, 0 }, 6), test::prism({ { 0, 0 }, { 8, 0 }, { 14, 6 }, { 6, 6 } }, 0, 3) }) {
+            const auto [voxels, taken, margin] = voxelize_part(shape, gap);
+            const geo::vector3<int> box_size = { (int)voxels.extent(0), (int)voxels.extent(1), (int)voxels.extent(2) };
+            const std::atomic<bool> running = true;
+            const std::optional<lattice> found = find_lattice(voxels, taken, margin, 1, running);
+            REQUIRE(found.has_value());
+            const lattice& l = *found;
+            CHECK(l.a.y == 0);
+            CHECK(l.a.z == 0);
+            CHECK(l.b.z == 0);
+            CHECK(l.cell_volume() > 0);
+            CHECK(l.cell_volume() < (box_size.x + margin) * (box_size.y + margin) * (box_size.z + margin)); // Tighter than a whole box apart
+
+            const geo::point3<int> max = { 4 * box_size.x, 4 * box_size.y, 4 * box_size.z };
+            const std::vector<geo::point3<int>> points = l.points(box_size, max);
+            CHECK(points.size() >= 8); // At least two along each axis
+
+            // Count how many copies take up each voxel, then check that every voxel of a copy is only taken by that copy itself
+            util::mdarray<int, 3> taken_count(max.x + 2 * margin, max.y + 2 * margin, max.z + 2 * margin);
+            for (const geo::point3<int> p : points) {
+                CHECK((p.x >= 0 and p.y >= 0 and p.z >= 0));
+                CHECK((p.x + box_size.x < max.x and p.y + box_size.y < max.y and p.z + box_size.z < max.z));
+                for (int i = 0; i < taken.extent(0); ++i) {
+                    for (int j = 0; j < taken.extent(1); ++j) {
+                        for (int k = 0; k < taken.extent(2); ++k) {
+                            taken_count[p.x + i, p.y + j, p.z + k] += taken.at(i, j, k) & 1;
+                        }
+                    }
+                }
+            }
+            int overlapping = 0;
+            for (const geo::point3<int> p : points) {
+                for (int i = 0; i < voxels.extent(0); ++i) {
+                    for (int j = 0; j < voxels.extent(1); ++j) {
+                        for (int k = 0; k < voxels.extent(2); ++k) {
+                            if ((voxels.at(i, j, k) & 1) != 0 and taken_count[p.x + margin + i, p.y + margin + j, p.z + margin + k] != 1) {
+                                ++overlapping;
+                            }
+                        }
+                    }
+                }
+            }
+            CHECK(overlapping == 0);
+        }
+    }
+}
+
+TEST_CASE("lowest layer first", "[lattice]") {
+    const auto [voxels, taken, margin] = voxelize_part(test::sphere({ 0, 0, 0 }, 6), 0);
+    const geo::vector3<int> box_size = { (int)voxels.extent(0), (int)voxels.extent(1), (int)voxels.extent(2) };
+    const std::atomic<bool> running = true;
+    const std::optional<lattice> found = find_lattice(voxels, taken, margin, 1, running);
+    REQUIRE(found.has_value());
+    const std::vector<geo::point3<int>> points = found->points(box_size, { 60, 60, 60 });
+    REQUIRE(not points.empty());
+    CHECK(points.front() == geo::point3<int>{ 0, 0, 0 });
+    for (std::size_t i = 1; i < points.size(); ++i) {
+        CHECK(points[i - 1].z <= points[i].z);
+    }
+}
+
+TEST_CASE("stops when cancelled", "[lattice]") {
+    const auto [voxels, taken, margin] = voxelize_part(test::sphere({ 0, 0, 0 }, 6), 0);
+    const std::atomic<bool> running = false;
+    CHECK(not find_lattice(voxels, taken, margin, 1, running).has_value());
+}
+
+} // namespace
+} // namespace pstack::calc
@@ -0,0 +1,62 @@
+#include "pstack/calc/mesh.hpp"
+#include "pstack/calc/test/shapes.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+namespace pstack::calc {
+namespace {
+
+TEST_CASE("shared corners", "[mesh]") {
+    // Each corner of a box is shared by several of its 12 triangles, but is only stored once
+    const mesh b = test::box({ 1, 2, 3 }, { 4, 6, 8 });
+    CHECK(b.triangle_count() == 12);
+    CHECK(b.indices().size() == 36);
+    CHECK(b.vertices().size() == 8);
+    CHECK(b.normals().size() == 12);
+
+    // Around the sphere, the last segment of each ring is worked out separately from the first but lands on the same corners
+    const mesh s = test::sphere({ 0, 0, 0 }, 5, 16, 32);
+    CHECK(s.vertices().size() == 2 + 15 * 32);
+}
+
+TEST_CASE("weld spacing", "[mesh]") {
+    const float near = (float)(mesh_builder::weld_spacing / 10);
+    const float far = (float)(mesh_builder::weld_spacing * 4);
+    const geo::point3<float> corner = { 1, 2, 3 };
+    mesh_builder builder{};
+    builder.push_back(test::make_triangle(corner, { 2, 2, 3 }, { 1, 3, 3 }));
+    builder.push_back(test::make_triangle(corner + geo::vector3<float>{ near, -near, near }, { 1, 3, 3 }, { 1, 2, 4 }));
+    builder.push_back(test::make_triangle(corner + geo::vector3<float>{ far, 0, 0 }, { 1, 2, 4 }, { 2, 2, 3 }));
+    const mesh m = builder.build();
+
+    REQUIRE(m.triangle_count() == 3);
+    CHECK(m.vertices().size() == 5);
+    const std::vector<std::uint32_t>& indices = m.indices();
+    CHECK(indices[0] == indices[3]); // Within the spacing, so welded together
+    CHECK(indices[0] != indices[6]); // Too far apart
+    CHECK(indices[2] == indices[4]);
+    CHECK(indices[5] == indices[7]);
+    CHECK(indices[1] == indices[8]);
+    // The welded vertex is where the first triangle put it
+    CHECK(m.vertex(indices[3]) == corner);
+}
+
+TEST_CASE("triangles round trip", "[mesh]") {
+    const mesh s = test::sphere({ 3, -2, 1 }, 4, 8, 12);
+    const std::vector<geo::triangle> triangles = s.triangles();
+    REQUIRE(triangles.size() == s.triangle_count());
+    const mesh copy(triangles);
+    CHECK(copy.vertices().size() == s.vertices().size());
+    CHECK(copy.indices() == s.indices());
+    int differences = 0;
+    for (std::size_t index = 0; index != s.triangle_count(); ++index) {
+        const geo::triangle lhs = s.triangle(index);
+        const geo::triangle rhs = copy.triangle(index);
+        differences += lhs.normal != rhs.normal or lhs.v1 != rhs.v1 or lhs.v2 != rhs.v2 or lhs.v3 != rhs.v3;
+        differences += lhs.v1 != triangles[index].v1 or lhs.v2 != triangles[index].v2 or lhs.v3 != triangles[index].v3;
+    }
+    CHECK(differences == 0);
+}
+
+} // namespace
+} // namespace pstack::calc
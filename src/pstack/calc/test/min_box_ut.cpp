@@ -0,0 +1,48 @@
+#include "pstack/calc/min_box.hpp"
+#include "pstack/calc/test/shapes.hpp"
+#include "pstack/geo/functions.hpp"
+#include "pstack/geo/matrix3.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+namespace pstack::calc {
+namespace {
+
+geo::vector3<float> box_size(const mesh& m) {
+    const mesh::bounding_t bounding = m.bounding();
+    return bounding.max - bounding.min;
+}
+
+TEST_CASE("rotated box", "[min_box]") {
+    const mesh original = test::box({ 0, 0, 0 }, { 10, 6, 2 });
+    const geo::matrix3<float> turns[] = {
+        geo::eye3<float>,
+        geo::rot3_z<float>(geo::radians(0.5)),
+        geo::rot3<float>({ 1, 2, 3 }, geo::radians(0.7)),
+        geo::rot3<float>({ -2, 1, 1 }, geo::radians(2.1)) * geo::rot3_x<float>(geo::radians(0.3)),
+    };
+    for (const geo::matrix3<float>& turn : turns) {
+        mesh m = original;
+        m.rotate(turn);
+        m.rotate(min_box_rotation(m));
+        const geo::vector3<float> size = box_size(m);
+        // Recovers the box itself, with its longest side along x and its shortest along z
+        CHECK(size.x * size.y * size.z < 120 * 1.01f);
+        CHECK(size.x > 9.9f);
+        CHECK(size.x < 10.1f);
+        CHECK(size.y > 5.9f);
+        CHECK(size.y < 6.1f);
+        CHECK(size.z > 1.9f);
+        CHECK(size.z < 2.1f);
+    }
+}
+
+TEST_CASE("never worse than unrotated", "[min_box]") {
+    mesh m = test::sphere({ 0, 0, 0 }, 5);
+    const geo::vector3<float> before = box_size(m);
+    m.rotate(min_box_rotation(m));
+    const geo::vector3<float> after = box_size(m);
+    CHECK(after.x * after.y * after.z <= before.x * before.y * before.z * 1.0001f);
+}
+
+} // namespace
+} // namespace pstack::calc
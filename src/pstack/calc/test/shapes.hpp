@@ -0,0 +1,83 @@
+#ifndef PSTACK_CALC_TEST_SHAPES_HPP
+#define PSTACK_CALC_TEST_SHAPES_HPP
+
+#include "pstack/calc/mesh.hpp"
+#include "pstack/calc/part.hpp"
+#include "pstack/geo/point3.hpp"
+#include "pstack/geo/triangle.hpp"
+#include "pstack/geo/vector3.hpp"
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <numbers>
+#include <utility>
+#include <vector>
+
+namespace pstack::calc::test {
+
+// Facing the side from which the corners go anticlockwise
+inline geo::triangle make_triangle(const geo::point3<float> v1, const geo::point3<float> v2, const geo::point3<float> v3) {
+    const geo::vector3<float> normal = geo::cross(v2 - v1, v3 - v1);
+    return { normal / std::sqrt(geo::dot(normal, normal)), v1, v2, v3 };
+}
+
+// A closed prism from `bottom` to `top` over the polygon, which goes anticlockwise and must be star-shaped around its first corner
+inline mesh prism(const std::vector<std::array<float, 2>>& polygon, const float bottom, const float top) {
+    const auto corner = [&](const std::size_t i, const float z) {
+        return geo::point3<float>{ polygon[i % polygon.size()][0], polygon[i % polygon.size()][1], z };
+    };
+    std::vector<geo::triangle> triangles{};
+    for (std::size_t i = 1; i + 1 < polygon.size(); ++i) {
+        triangles.push_back(make_triangle(corner(0, bottom), corner(i + 1, bottom), corner(i, bottom)));
+        triangles.push_back(make_triangle(corner(0, top), corner(i, top), corner(i + 1, top)));
+    }
+    for (std::size_t i = 0; i != polygon.size(); ++i) {
+        triangles.push_back(make_triangle(corner(i, bottom), corner(i + 1, bottom), corner(i + 1, top)));
+        triangles.push_back(make_triangle(corner(i, bottom), corner(i + 1, top), corner(i, top)));
+    }
+    return mesh(triangles);
+}
+
+inline mesh box(const geo::point3<float> min, const geo::point3<float> max) {
+    return prism({ { min.x, min.y }, { max.x, min.y }, { max.x, max.y }, { min.x, max.y } }, min.z, max.z);
+}
+
+inline mesh sphere(const geo::point3<float> centre, const float radius, const int rings = 16, const int segments = 32) {
+    const auto at = [&](const int ring, const int segment) {
+        const double polar = std::numbers::pi * ring / rings;
+        const double azimuth = 2 * std::numbers::pi * segment / segments;
+        return centre + radius * geo::vector3<float>{ (float)(std::sin(polar) * std::cos(azimuth)), (float)(std::sin(polar) * std::sin(azimuth)), (float)std::cos(polar) };
+    };
+    std::vector<geo::triangle> triangles{};
+    for (int ring = 0; ring != rings; ++ring) {
+        for (int segment = 0; segment != segments; ++segment) {
+            if (ring != 0) {
+                triangles.push_back(make_triangle(at(ring, segment), at(ring + 1, segment), at(ring, segment + 1)));
+            }
+            if (ring + 1 != rings) {
+                triangles.push_back(make_triangle(at(ring, segment + 1), at(ring + 1, segment), at(ring + 1, segment + 1)));
+            }
+        }
+    }
+    return mesh(triangles);
+}
+
+// A part as `initialize_part` would load it, without reading it from a file
+inline std::shared_ptr<const part> make_part(mesh m, const int quantity, const int rotation_index, const int min_hole = 1) {
+    part out{};
+    out.quantity = quantity;
+    out.rotation_index = rotation_index;
+    out.min_hole = min_hole;
+    out.mesh = std::move(m);
+    out.mesh.set_baseline({ 0, 0, 0 });
+    const mesh::volume_and_centroid_t volume_and_centroid = out.mesh.volume_and_centroid();
+    out.volume = volume_and_centroid.volume;
+    out.centroid = volume_and_centroid.centroid;
+    out.triangle_count = (int)out.mesh.triangle_count();
+    return std::make_shared<const part>(std::move(out));
+}
+
+} // namespace pstack::calc::test
+
+#endif // PSTACK_CALC_TEST_SHAPES_HPP
@@ -0,0 +1,322 @@
+#include "pstack/calc/extreme_points.hpp"
+#include "pstack/calc/stacker.hpp"
+#include "pstack/calc/test/shapes.hpp"
+#include "pstack/calc/voxelize.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <span>
+
+namespace pstack::calc {
+namespace {
+
+std::vector<stack_result> stack(std::vector<std::shared_ptr<const part>> parts, const stack_settings& settings) {
+    std::vector<stack_result> results{};
+    stacker{}.stack({
+        .parts = std::move(parts),
+        .settings = settings,
+        .set_progress = [](double, double) {},
+        .display_mesh = [](const mesh&, geo::point3<int>) {},
+        .on_success = [&](std::vector<stack_result> r, std::chrono::system_clock::duration) { results = std::move(r); },
+        .on_failure = [] {},
+        .on_finish = [] {},
+    });
+    return results;
+}
+
+// Every piece voxelized again where it was placed, all in grids of the same size
+std::vector<util::mdarray<Bool, 3>> placed_solids(const stack_result& result, const stack_settings& settings) {
+    std::vector<mesh> placed{};
+    geo::vector3<int> size = { 1, 1, 1 };
+    for (const stack_result::piece& piece : result.pieces) {
+        mesh m = piece.part->mesh;
+        m.scale(1 / settings.resolution);
+        m.rotate(piece.rotation);
+        // One voxel further out, so that nothing falls below zero
+        placed.emplace_back().add(m, piece.translation + geo::vector3<float>{ 1, 1, 1 });
+        const geo::point3<float> max = placed.back().bounding().max;
+        size = { std::max(size.x, geo::ceil(max.x) + 2), std::max(size.y, geo::ceil(max.y) + 2), std::max(size.z, geo::ceil(max.z) + 2) };
+    }
+
+    std::vector<util::mdarray<Bool, 3>> solids{};
+    for (std::size_t p = 0; p != placed.size(); ++p) {
+        voxelize_solid(placed[p], solids.emplace_back(size.x, size.y, size.z), result.pieces[p].part->min_hole, settings.fill);
+    }
+    return solids;
+}
+
+// How many voxels are taken up by more than one piece.
+// Without a clearance, each piece takes up the voxels which `dilate` marks for it, which keeps a voxel between pieces.
+int overlapping_voxels(const stack_result& result, const stack_settings& settings) {
+    const std::vector<util::mdarray<Bool, 3>> solids = placed_solids(result, settings);
+    if (solids.empty()) {
+        return 0;
+    }
+    const int size_x = solids[0].extent(0);
+    const int size_y = solids[0].extent(1);
+    const int size_z = solids[0].extent(2);
+
+    util::mdarray<int, 3> count(size_x, size_y, size_z);
+    util::mdarray<Bool, 3> taken{};
+    const int spacing = settings.clearance == 0 ? 1 : 0;
+    const bool itself = spacing == 0;
+    for (const util::mdarray<Bool, 3>& solid : solids) {
+        taken.assign(util::mdspan<int, 3>(count).extents(), false);
+        for (int x = 0; x + spacing < size_x; ++x) {
+            for (int y = 0; y + spacing < size_y; ++y) {
+                for (int z = 0; z + spacing < size_z; ++z) {
+                    if (solid[x, y, z]) {
+                        for (int i = 0; i <= spacing; ++i) {
+                            for (int j = 0; j <= spacing; ++j) {
+                                for (int k = 0; k <= spacing; ++k) {
+                                    taken[x + i, y + j, z + k] |= itself or i != 0 or j != 0 or k != 0;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        for (int x = 0; x != size_x; ++x) {
+            for (int y = 0; y != size_y; ++y) {
+                for (int z = 0; z != size_z; ++z) {
+                    count[x, y, z] += taken[x, y, z];
+                }
+            }
+        }
+    }
+
+    int overlapping = 0;
+    for (int x = 0; x != size_x; ++x) {
+        for (int y = 0; y != size_y; ++y) {
+            for (int z = 0; z != size_z; ++z) {
+                overlapping += count[x, y, z] > 1;
+            }
+        }
+    }
+    return overlapping;
+}
+
+// The shortest distance between the voxels of any two pieces, measured between their cubes in voxels, as `dilate` measures a clearance
+double closest_gap(const stack_result& result, const stack_settings& settings) {
+    const std::vector<util::mdarray<Bool, 3>> solids = placed_solids(result, settings);
+    // Only the voxels on the outside of each piece can be closest to another
+    std::vector<std::vector<geo::point3<int>>> outsides{};
+    for (const util::mdarray<Bool, 3>& solid : solids) {
+        const auto covered = [&](const int x, const int y, const int z) {
+            return x >= 0 and y >= 0 and z >= 0 and x < solid.extent(0) and y < solid.extent(1) and z < solid.extent(2) and solid[x, y, z];
+        };
+        std::vector<geo::point3<int>>& outside = outsides.emplace_back();
+        for (int x = 0; x != solid.extent(0); ++x) {
+            for (int y = 0; y != solid.extent(1); ++y) {
+                for (int z = 0; z != solid.extent(2); ++z) {
+                    if (covered(x, y, z) and not (covered(x - 1, y, z) and covered(x + 1, y, z) and covered(x, y - 1, z) and covered(x, y + 1, z) and covered(x, y, z - 1) and covered(x, y, z + 1))) {
+                        outside.push_back({ x, y, z });
+                    }
+                }
+            }
+        }
+    }
+
+    const auto apart = [](const int lhs, const int rhs) {
+        return std::max(0, std::abs(lhs - rhs) - 1);
+    };
+    int closest = std::numeric_limits<int>::max();
+    for (std::size_t p = 0; p != outsides.size(); ++p) {
+        for (std::size_t q = p + 1; q != outsides.size(); ++q) {
+            for (const geo::point3<int> a : outsides[p]) {
+                for (const geo::point3<int> b : outsides[q]) {
+                    const int x = apart(a.x, b.x);
+                    const int y = apart(a.y, b.y);
+                    const int z = apart(a.z, b.z);
+                    closest = std::min(closest, x * x + y * y + z * z);
+                }
+            }
+        }
+    }
+    return std::sqrt(closest);
+}
+
+// A few different shapes, so that smaller pieces have gaps between bigger ones to go into
+std::vector<std::shared_ptr<const part>> mixed_parts(const int rotation_index) {
+    return {
+        test::make_part(test::box({ 0, 0, 0 }, { 12, 7, 4 }), 4, rotation_index),
+        test::make_part(test::sphere({ 0, 0, 0 }, 4), 5, rotation_index),
+        test::make_part(test::prism({ { 0, 0 }, { 9, 0 }, { 9, 2 }, { 2, 2 }, { 2, 9 }, { 0, 9 } }, 0, 3), 6, rotation_index),
+    };
+}
+
+// Every instance of every part is placed exactly once, on plates which fit within the largest bounds, without touching one another
+void check_stacked(const std::vector<stack_result>& results, const std::vector<std::shared_ptr<const part>>& parts, const stack_settings& settings) {
+    REQUIRE(not results.empty());
+    for (const std::shared_ptr<const part>& p : parts) {
+        std::size_t placed = 0;
+        for (const stack_result& result : results) {
+            placed += std::ranges::count(result.pieces, p, &stack_result::piece::part);
+        }
+        CHECK(placed == p->quantity);
+    }
+    for (const stack_result& result : results) {
+        const mesh::bounding_t bounding = result.mesh.bounding();
+        CHECK(bounding.min.x >= -1e-3f);
+        CHECK(bounding.min.y >= -1e-3f);
+        CHECK(bounding.min.z >= -1e-3f);
+        CHECK(bounding.max.x <= std::max(settings.x_min, settings.x_max) + 1e-3f);
+        CHECK(bounding.max.y <= std::max(settings.y_min, settings.y_max) + 1e-3f);
+        CHECK(bounding.max.z <= std::max(settings.z_min, settings.z_max) + 1e-3f);
+        CHECK(overlapping_voxels(result, settings) == 0);
+    }
+}
+
+TEST_CASE("placement modes", "[stacker]") {
+    for (const placement_mode placement : { placement_mode::scan, placement_mode::extreme_points, placement_mode::drop }) {
+        const stack_settings settings{ .x_min = 20, .x_max = 60, .y_min = 20, .y_max = 60, .z_min = 10, .z_max = 60, .placement = placement };
+        const std::vector<std::shared_ptr<const part>> parts = mixed_parts(1);
+        const std::vector<stack_result> results = stack(parts, settings);
+        CHECK(results.size() == 1);
+        check_stacked(results, parts, settings);
+    }
+}
+
+TEST_CASE("multiple plates", "[stacker]") {
+    // Far more than fits on one plate, so the rest overflow onto further plates of the same size
+    const stack_settings settings{ .x_min = 25, .x_max = 25, .y_min = 25, .y_max = 25, .z_min = 12, .z_max = 12, .multiple_plates = true };
+    const std::vector<std::shared_ptr<const part>> parts = mixed_parts(1);
+    const std::vector<stack_result> results = stack(parts, settings);
+    CHECK(results.size() > 1);
+    check_stacked(results, parts, settings);
+}
+
+TEST_CASE("batch growth", "[stacker]") {
+    // Starting from bounds too small for even one box, so that the bounds have to grow for every part
+    const stack_settings settings{ .x_min = 5, .x_max = 60, .y_min = 5, .y_max = 60, .z_min = 5, .z_max = 60, .batch_growth = true };
+    const std::vector<std::shared_ptr<const part>> parts = mixed_parts(1);
+    const std::vector<stack_result> results = stack(parts, settings);
+    CHECK(results.size() == 1);
+    check_stacked(results, parts, settings);
+}
+
+// Where the piece lies once placed, in voxels
+mesh::bounding_t placed_bounding(const stack_result::piece& piece, const stack_settings& settings) {
+    mesh m = piece.part->mesh;
+    m.scale(1 / settings.resolution);
+    m.rotate(piece.rotation);
+    mesh placed{};
+    placed.add(m, piece.translation);
+    return placed.bounding();
+}
+
+TEST_CASE("parity fill", "[stacker]") {
+    const stack_settings settings{ .x_min = 20, .x_max = 60, .y_min = 20, .y_max = 60, .z_min = 10, .z_max = 60, .fill = fill_mode::parity };
+    {
+        // The corner of each L-shaped prism stays open, so only the voxels of the L itself are taken up
+        const std::vector<std::shared_ptr<const part>> parts = mixed_parts(1);
+        const std::vector<stack_result> results = stack(parts, settings);
+        CHECK(results.size() == 1);
+        check_stacked(results, parts, settings);
+        REQUIRE(not results.empty());
+        const std::vector<util::mdarray<Bool, 3>> solids = placed_solids(results[0], settings);
+        int shapes = 0;
+        for (std::size_t p = 0; p != solids.size(); ++p) {
+            if (results[0].pieces[p].part != parts[2]) {
+                continue;
+            }
+            ++shapes;
+            const mesh::bounding_t bounding = placed_bounding(results[0].pieces[p], settings);
+            const geo::vector3<float> size = bounding.max - bounding.min;
+            int covered = 0;
+            for (const Bool voxel : std::span(util::mdspan<const Bool, 3>(solids[p]).data_handle(), util::mdspan<const Bool, 3>(solids[p]).size())) {
+                covered += voxel;
+            }
+            // The L covers 32 of the 81 square millimetres of its bounding square, and its surface adds at most one layer of voxels
+            CHECK(covered < 0.6f * (size.x + 1) * (size.y + 1) * (size.z + 1));
+        }
+        CHECK(shapes == 6);
+    }
+    {
+        // A sealed cavity is filled in, so nothing is placed inside it where it could never be taken out
+        mesh hollow{};
+        hollow.add(test::box({ 0, 0, 0 }, { 20, 20, 20 }), { 0, 0, 0 });
+        hollow.add(test::box({ 17, 3, 3 }, { 3, 17, 17 }), { 0, 0, 0 }); // Inside out, as its corners go the other way round
+        const std::vector<std::shared_ptr<const part>> parts = {
+            test::make_part(std::move(hollow), 1, 1),
+            test::make_part(test::box({ 0, 0, 0 }, { 4, 4, 4 }), 8, 1),
+        };
+        const stack_settings roomy{ .x_min = 40, .x_max = 60, .y_min = 40, .y_max = 60, .z_min = 30, .z_max = 60, .fill = fill_mode::parity };
+        const std::vector<stack_result> results = stack(parts, roomy);
+        CHECK(results.size() == 1);
+        check_stacked(results, parts, roomy);
+        REQUIRE(not results.empty());
+        const auto outer = std::ranges::find(results[0].pieces, parts[0], &stack_result::piece::part);
+        REQUIRE(outer != results[0].pieces.end());
+        const mesh::bounding_t box = placed_bounding(*outer, roomy);
+        for (const stack_result::piece& piece : results[0].pieces) {
+            if (piece.part == parts[1]) {
+                const mesh::bounding_t cube = placed_bounding(piece, roomy);
+                const bool inside = cube.min.x < box.max.x and cube.max.x > box.min.x
+                                and cube.min.y < box.max.y and cube.max.y > box.min.y
+                                and cube.min.z < box.max.z and cube.max.z > box.min.z;
+                CHECK(not inside);
+            }
+        }
+    }
+}
+
+TEST_CASE("resampled rotations", "[stacker]") {
+    // Every orientation is resampled from a finer grid rather than voxelized on its own, but must still cover everything the piece does
+    const stack_settings settings{ .x_min = 20, .x_max = 60, .y_min = 20, .y_max = 60, .z_min = 10, .z_max = 60, .resample_rotations = true };
+    const std::vector<std::shared_ptr<const part>> parts = mixed_parts(2);
+    const std::vector<stack_result> results = stack(parts, settings);
+    CHECK(results.size() == 1);
+    check_stacked(results, parts, settings);
+}
+
+TEST_CASE("exact clearance", "[stacker]") {
+    for (const double resolution : { 1.0, 0.5 }) {
+        const stack_settings settings{ .resolution = resolution, .x_min = 20, .x_max = 80, .y_min = 20, .y_max = 80, .z_min = 10, .z_max = 80, .clearance = 2.5 };
+        const std::vector<std::shared_ptr<const part>> parts = mixed_parts(1);
+        const std::vector<stack_result> results = stack(parts, settings);
+        CHECK(results.size() == 1);
+        check_stacked(results, parts, settings);
+        // Pieces keep the whole clearance apart, and are packed no further apart than they need to be
+        const double gap = closest_gap(results[0], settings) * resolution;
+        CHECK(gap >= 2.5);
+        CHECK(gap < 2.5 + 2 * resolution);
+    }
+}
+
+TEST_CASE("extreme points with clearance", "[stacker]") {
+    // The plate is only one part high, so that the full scan would tuck each L into the corner of the one before,
+    // while the candidates past the clearance of each L always leave room for the next one
+    const stack_settings settings{ .x_min = 60, .x_max = 60, .y_min = 60, .y_max = 60, .z_min = 6, .z_max = 6, .placement = placement_mode::extreme_points, .clearance = 2.5 };
+    const mesh l_shape = test::prism({ { 0, 0 }, { 9, 0 }, { 9, 2 }, { 2, 2 }, { 2, 9 }, { 0, 9 } }, 0, 3);
+    const std::vector<stack_result> results = stack({ test::make_part(l_shape, 6, 0) }, settings);
+    REQUIRE(results.size() == 1);
+    REQUIRE(results[0].pieces.size() == 6);
+
+    // Every piece goes on one of the candidates left by the pieces before it, each grown by the clearance
+    const int margin = clearance_margin(2.5);
+    const geo::vector3<int> box_size = l_shape.bounding().box_size;
+    extreme_points candidates{};
+    for (const stack_result::piece& piece : results[0].pieces) {
+        const geo::point3<float> min = placed_bounding(piece, settings).min;
+        const geo::point3<int> position = { (int)std::lround(min.x), (int)std::lround(min.y), (int)std::lround(min.z) };
+        CHECK(std::ranges::find(candidates.points(), position) != candidates.points().end());
+        const geo::point3<int> low = { std::max(position.x - margin, 0), std::max(position.y - margin, 0), std::max(position.z - margin, 0) };
+        candidates.add_box(low, position + box_size + margin - low);
+    }
+    CHECK(closest_gap(results[0], settings) >= 2.5);
+}
+
+TEST_CASE("lattice tiling", "[stacker]") {
+    // The lattice only fits a few layers of spheres within the initial bounds, so the rest have to be placed around them
+    const stack_settings settings{ .x_min = 30, .x_max = 120, .y_min = 30, .y_max = 120, .z_min = 20, .z_max = 20, .tile_lattices = true };
+    const std::vector<stack_result> results = stack({ test::make_part(test::sphere({ 0, 0, 0 }, 5), 20, 0) }, settings);
+    REQUIRE(results.size() == 1);
+    CHECK(results[0].pieces.size() == 20);
+    CHECK(overlapping_voxels(results[0], settings) == 0);
+}
+
+} // namespace
+} // namespace pstack::calc
@@ -0,0 +1,93 @@
+#include "pstack/calc/voxel_mesh.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <random>
+
+namespace pstack::calc {
+namespace {
+
+double area(const mesh& m) {
+    double out = 0;
+    for (std::size_t index = 0; index != m.triangle_count(); ++index) {
+        const geo::triangle t = m.triangle(index);
+        const geo::vector3<float> c = geo::cross(t.v2 - t.v1, t.v3 - t.v1);
+        out += std::sqrt(geo::dot(c, c)) / 2;
+    }
+    return out;
+}
+
+bool near(const double lhs, const double rhs) {
+    return std::abs(lhs - rhs) <= 1e-4 * std::max(1.0, std::abs(rhs));
+}
+
+TEST_CASE("single voxel", "[voxel_mesh]") {
+    util::mdarray<Bool, 3> voxels(3, 3, 3);
+    voxels[1, 1, 1] = true;
+    const mesh m = voxel_mesh(voxels, { 10, 20, 30 }, 0.5f);
+    CHECK(m.triangle_count() == 12);
+    CHECK(near(m.volume_and_centroid().volume, 0.125));
+    const mesh::bounding_t bounding = m.bounding();
+    CHECK(bounding.min == geo::point3<float>{ 10.25f, 20.25f, 30.25f });
+    CHECK(bounding.max == geo::point3<float>{ 10.75f, 20.75f, 30.75f });
+}
+
+TEST_CASE("merged faces", "[voxel_mesh]") {
+    // A solid block is just a box, however many voxels it covers
+    util::mdarray<Bool, 3> voxels(3, 4, 5);
+    for (std::size_t x = 0; x != 3; ++x) {
+        for (std::size_t y = 0; y != 4; ++y) {
+            for (std::size_t z = 0; z != 5; ++z) {
+                voxels[x, y, z] = true;
+            }
+        }
+    }
+    const mesh block = voxel_mesh(voxels, { 0, 0, 0 }, 1);
+    CHECK(block.triangle_count() == 12);
+    CHECK(near(block.volume_and_centroid().volume, 60));
+    // One vertex for each corner of the box, shared by the faces which meet there
+    CHECK(block.vertices().size() == 8);
+
+    // A sealed cavity of two voxels adds its own walls inside, one by two by one voxels
+    voxels[1, 1, 2] = false;
+    voxels[1, 2, 2] = false;
+    const mesh hollow = voxel_mesh(voxels, { 0, 0, 0 }, 1);
+    CHECK(near(hollow.volume_and_centroid().volume, 58));
+    CHECK(near(area(hollow), area(block) + 2 * (2 + 1 + 2)));
+}
+
+TEST_CASE("closed surface", "[voxel_mesh]") {
+    // The mesh of any voxels encloses exactly their volume, and its area is that of the faces between covered and uncovered voxels
+    std::mt19937 random(7);
+    for (const double density : { 0.1, 0.5, 0.9 }) {
+        util::mdarray<Bool, 3> voxels(11, 9, 13);
+        std::bernoulli_distribution covered(density);
+        int count = 0;
+        for (std::size_t x = 0; x != voxels.extent(0); ++x) {
+            for (std::size_t y = 0; y != voxels.extent(1); ++y) {
+                for (std::size_t z = 0; z != voxels.extent(2); ++z) {
+                    voxels[x, y, z] = covered(random);
+                    count += voxels[x, y, z];
+                }
+            }
+        }
+        const auto at = [&](const int x, const int y, const int z) {
+            return x >= 0 and y >= 0 and z >= 0 and x < voxels.extent(0) and y < voxels.extent(1) and z < voxels.extent(2) and voxels[x, y, z];
+        };
+        int faces = 0;
+        for (int x = -1; x < (int)voxels.extent(0); ++x) {
+            for (int y = -1; y < (int)voxels.extent(1); ++y) {
+                for (int z = -1; z < (int)voxels.extent(2); ++z) {
+                    faces += (at(x, y, z) != at(x + 1, y, z)) + (at(x, y, z) != at(x, y + 1, z)) + (at(x, y, z) != at(x, y, z + 1));
+                }
+            }
+        }
+
+        const mesh m = voxel_mesh(voxels, { 1, 2, 3 }, 0.25f);
+        CHECK(near(m.volume_and_centroid().volume, count * 0.25 * 0.25 * 0.25));
+        CHECK(near(area(m), faces * 0.25 * 0.25));
+        CHECK(m.triangle_count() <= 2 * (std::size_t)faces);
+    }
+}
+
+} // namespace
+} // namespace pstack::calc
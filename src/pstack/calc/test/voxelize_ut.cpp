@@ -0,0 +1,454 @@
+#include "pstack/calc/rotations.hpp"
+#include "pstack/calc/test/shapes.hpp"
+#include "pstack/calc/voxelize.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace pstack::calc {
+namespace {
+
+// The voxels are centred on whole numbers, so that voxel `i` covers `[i - 0.5, i + 0.5]` along each axis
+util::mdarray<Bool, 3> surface_of(const mesh& m, const geo::vector3<int> size) {
+    util::mdarray<Bool, 3> surface(size.x, size.y, size.z);
+    voxelize_surface(m, surface);
+    return surface;
+}
+
+util::mdarray<Bool, 3> solid_of(const mesh& m, const geo::vector3<int> size, const std::size_t carver_size, const fill_mode fill) {
+    util::mdarray<Bool, 3> solid(size.x, size.y, size.z);
+    voxelize_solid(m, solid, carver_size, fill);
+    return solid;
+}
+
+int count(const util::mdarray<Bool, 3>& voxels) {
+    int out = 0;
+    for (std::size_t x = 0; x != voxels.extent(0); ++x) {
+        for (std::size_t y = 0; y != voxels.extent(1); ++y) {
+            for (std::size_t z = 0; z != voxels.extent(2); ++z) {
+                out += voxels[x, y, z];
+            }
+        }
+    }
+    return out;
+}
+
+// The convex fill as it first was: the carver floods one position at a time from the border, testing every voxel it would cover,
+// then everything it reached is carved away, and the rest is filled between its outermost surface voxels along z, then y, then x
+util::mdarray<Bool, 3> reference_convex_fill(const util::mdarray<Bool, 3>& surface, const int carver_size) {
+    const int width = surface.extent(0);
+    const int length = surface.extent(1);
+    const int depth = surface.extent(2);
+    const int last_x = width - carver_size;
+    const int last_y = length - carver_size;
+    const int last_z = depth - carver_size;
+    const auto fits = [&](const int x, const int y, const int z) {
+        for (int i = 0; i != carver_size; ++i) {
+            for (int j = 0; j != carver_size; ++j) {
+                for (int k = 0; k != carver_size; ++k) {
+                    if (surface[x + i, y + j, z + k]) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    };
+
+    util::mdarray<Bool, 3> visited(width, length, depth);
+    util::mdarray<Bool, 3> carved(width, length, depth);
+    std::vector<geo::point3<int>> stack{};
+    for (int x = 0; x <= last_x; ++x) {
+        for (int y = 0; y <= last_y; ++y) {
+            for (int z = 0; z <= last_z; ++z) {
+                if (x == 0 or y == 0 or z == 0 or x == last_x or y == last_y or z == last_z) {
+                    stack.push_back({ x, y, z });
+                }
+            }
+        }
+    }
+    while (not stack.empty()) {
+        const auto [x, y, z] = stack.back();
+        stack.pop_back();
+        if (x < 0 or y < 0 or z < 0 or x > last_x or y > last_y or z > last_z or visited[x, y, z]) {
+            continue;
+        }
+        visited[x, y, z] = true;
+        if (not fits(x, y, z)) {
+            continue;
+        }
+        for (int i = 0; i != carver_size; ++i) {
+            for (int j = 0; j != carver_size; ++j) {
+                for (int k = 0; k != carver_size; ++k) {
+                    carved[x + i, y + j, z + k] = true;
+                }
+            }
+        }
+        stack.insert(stack.end(), { { x - 1, y, z }, { x + 1, y, z }, { x, y - 1, z }, { x, y + 1, z }, { x, y, z - 1 }, { x, y, z + 1 } });
+    }
+
+    util::mdarray<Bool, 3> solid = surface;
+    const auto fill_line = [&](const auto at, const int length) {
+        int min = length;
+        int max = -1;
+        for (int i = 0; i != length; ++i) {
+            if (at(i)) {
+                min = std::min(min, i);
+                max = std::max(max, i);
+            }
+        }
+        for (int i = min; i < max; ++i) {
+            at(i) = true;
+        }
+    };
+    for (int x = 0; x != width; ++x) {
+        for (int y = 0; y != length; ++y) {
+            fill_line([&](const int z) -> Bool& { return solid[x, y, z]; }, depth);
+        }
+    }
+    for (int x = 0; x != width; ++x) {
+        for (int z = 0; z != depth; ++z) {
+            fill_line([&](const int y) -> Bool& { return solid[x, y, z]; }, length);
+        }
+    }
+    for (int y = 0; y != length; ++y) {
+        for (int z = 0; z != depth; ++z) {
+            fill_line([&](const int x) -> Bool& { return solid[x, y, z]; }, width);
+        }
+    }
+    for (int x = 0; x != width; ++x) {
+        for (int y = 0; y != length; ++y) {
+            for (int z = 0; z != depth; ++z) {
+                solid[x, y, z] = solid[x, y, z] and not carved[x, y, z];
+            }
+        }
+    }
+    return solid;
+}
+
+int differences(const util::mdarray<Bool, 3>& lhs, const util::mdarray<Bool, 3>& rhs) {
+    int out = 0;
+    for (std::size_t x = 0; x != lhs.extent(0); ++x) {
+        for (std::size_t y = 0; y != lhs.extent(1); ++y) {
+            for (std::size_t z = 0; z != lhs.extent(2); ++z) {
+                out += lhs[x, y, z] != rhs[x, y, z];
+            }
+        }
+    }
+    return out;
+}
+
+TEST_CASE("box", "[voxelize]") {
+    // Reaches into voxels 1 to 5 along each axis, and no further
+    const mesh m = test::box({ 0.75f, 0.75f, 0.75f }, { 5.25f, 5.25f, 5.25f });
+    const geo::vector3<int> size = { 7, 7, 7 };
+    CHECK(count(surface_of(m, size)) == 5 * 5 * 5 - 3 * 3 * 3);
+    for (const fill_mode fill : { fill_mode::convex, fill_mode::parity }) {
+        // Without a carver, nothing is filled in
+        CHECK(count(solid_of(m, size, 0, fill)) == 5 * 5 * 5 - 3 * 3 * 3);
+        for (const std::size_t carver_size : { 1, 3 }) {
+            const util::mdarray<Bool, 3> solid = solid_of(m, size, carver_size, fill);
+            CHECK(count(solid) == 5 * 5 * 5);
+            CHECK(not solid[0, 3, 3]);
+            CHECK(solid[1, 3, 3]);
+            CHECK(solid[5, 3, 3]);
+            CHECK(not solid[6, 3, 3]);
+        }
+    }
+}
+
+TEST_CASE("conservative surface", "[voxelize]") {
+    // Every voxel which any point of a triangle lies in is marked, however thin or steep the triangle
+    const mesh m = test::sphere({ 8.3f, 7.9f, 8.1f }, 6.7f);
+    const util::mdarray<Bool, 3> surface = surface_of(m, { 17, 17, 17 });
+    constexpr int steps = 40;
+    int missed = 0;
+    for (std::size_t index = 0; index != m.triangle_count(); ++index) {
+        const geo::triangle t = m.triangle(index);
+        for (int i = 0; i <= steps; ++i) {
+            for (int j = 0; i + j <= steps; ++j) {
+                const float a = (float)i / steps;
+                const float b = (float)j / steps;
+                const geo::point3<float> p = t.v1 + a * (t.v2 - t.v1) + b * (t.v3 - t.v1);
+                missed += not surface[(std::size_t)std::lround(p.x), (std::size_t)std::lround(p.y), (std::size_t)std::lround(p.z)];
+            }
+        }
+    }
+    CHECK(missed == 0);
+
+    // And nothing is marked further from the sphere than a voxel's half-diagonal, and the little which the facets fall inside it
+    int stray = 0;
+    for (std::size_t x = 0; x != surface.extent(0); ++x) {
+        for (std::size_t y = 0; y != surface.extent(1); ++y) {
+            for (std::size_t z = 0; z != surface.extent(2); ++z) {
+                const float distance = std::sqrt((x - 8.3f) * (x - 8.3f) + (y - 7.9f) * (y - 7.9f) + (z - 8.1f) * (z - 8.1f));
+                stray += surface[x, y, z] and std::abs(distance - 6.7f) > 0.95f;
+            }
+        }
+    }
+    CHECK(stray == 0);
+}
+
+TEST_CASE("slab boundaries", "[voxelize]") {
+    // Tall enough to be split into slabs along z, with a corner and a curved top for the carver to reach around
+    mesh m{};
+    m.add(test::box({ 0.75f, 0.75f, 0.75f }, { 4.25f, 4.25f, 30.25f }), { 0, 0, 0 });
+    m.add(test::box({ 4.25f, 0.75f, 0.75f }, { 10.25f, 4.25f, 5.25f }), { 0, 0, 0 });
+    m.add(test::sphere({ 5.5f, 5.5f, 35.5f }, 4.6f), { 0, 0, 0 });
+    const geo::vector3<int> size = { 12, 12, 42 };
+
+    // The same voxels come out however far up the part lies, and so wherever the slab boundaries fall across it
+    for (const fill_mode fill : { fill_mode::convex, fill_mode::parity }) {
+        const util::mdarray<Bool, 3> expected = solid_of(m, size, 2, fill);
+        for (int shift = 1; shift != 8; ++shift) {
+            mesh shifted{};
+            shifted.add(m, { 0, 0, (float)shift });
+            const util::mdarray<Bool, 3> solid = solid_of(shifted, size + geo::vector3<int>{ 0, 0, shift }, 2, fill);
+            int different = 0;
+            for (std::size_t x = 0; x != solid.extent(0); ++x) {
+                for (std::size_t y = 0; y != solid.extent(1); ++y) {
+                    for (std::size_t z = 0; z != solid.extent(2); ++z) {
+                        different += solid[x, y, z] != (z >= shift and expected[x, y, z - shift]);
+                    }
+                }
+            }
+            CHECK(different == 0);
+        }
+    }
+
+    // The tall box alone is filled right through
+    const mesh tower = test::box({ 0.75f, 0.75f, 0.75f }, { 3.25f, 3.25f, 100.25f });
+    CHECK(count(solid_of(tower, { 5, 5, 102 }, 1, fill_mode::convex)) == 3 * 3 * 100);
+    CHECK(count(solid_of(tower, { 5, 5, 102 }, 1, fill_mode::parity)) == 3 * 3 * 100);
+}
+
+TEST_CASE("fill modes", "[voxelize]") {
+    // A sealed cavity, whose walls reach into voxels 4 to 9, is filled by both, since the carver can never reach it
+    mesh hollow{};
+    hollow.add(test::box({ 0.75f, 0.75f, 0.75f }, { 11.25f, 11.25f, 11.25f }), { 0, 0, 0 });
+    hollow.add(test::box({ 3.75f, 3.75f, 3.75f }, { 9.25f, 9.25f, 9.25f }), { 0, 0, 0 });
+    CHECK(count(solid_of(hollow, { 13, 13, 13 }, 1, fill_mode::convex)) == 11 * 11 * 11);
+    CHECK(count(solid_of(hollow, { 13, 13, 13 }, 1, fill_mode::parity)) == 11 * 11 * 11);
+
+    // A U, two voxels thick, four wide between its posts, and three deep
+    mesh u{};
+    u.add(test::box({ 0.75f, 0.75f, 0.75f }, { 2.25f, 3.25f, 8.25f }), { 0, 0, 0 });
+    u.add(test::box({ 2.25f, 0.75f, 0.75f }, { 6.75f, 3.25f, 2.25f }), { 0, 0, 0 });
+    u.add(test::box({ 6.75f, 0.75f, 0.75f }, { 8.25f, 3.25f, 8.25f }), { 0, 0, 0 });
+    const geo::vector3<int> size = { 10, 5, 10 };
+    constexpr int u_volume = 2 * (2 * 3 * 8) + 4 * 3 * 2;
+    constexpr int inside_u = 4 * 3 * 6;
+    // Both keep the U open only where the carver fits into it
+    for (const fill_mode fill : { fill_mode::convex, fill_mode::parity }) {
+        CHECK(count(solid_of(u, size, 1, fill)) == u_volume);
+        CHECK(count(solid_of(u, size, 20, fill)) == u_volume + inside_u);
+    }
+
+    // A box without its lid lets the carver in, but the rays still find its inside, since only those along z are thrown off
+    std::vector<geo::triangle> open_box = test::box({ 0.75f, 0.75f, 0.75f }, { 7.25f, 7.25f, 7.25f }).triangles();
+    std::erase_if(open_box, [](const geo::triangle& t) { return t.normal.z > 0.5f; });
+    const util::mdarray<Bool, 3> convex = solid_of(mesh(open_box), { 9, 9, 9 }, 1, fill_mode::convex);
+    const util::mdarray<Bool, 3> parity = solid_of(mesh(open_box), { 9, 9, 9 }, 1, fill_mode::parity);
+    CHECK(not convex[4, 4, 4]);
+    CHECK(count(parity) == 7 * 7 * 7);
+
+    // Both agree on a convex part
+    const mesh ball = test::sphere({ 7.2f, 6.9f, 7.1f }, 5.8f);
+    CHECK(count(solid_of(ball, { 15, 15, 15 }, 1, fill_mode::convex)) == count(solid_of(ball, { 15, 15, 15 }, 1, fill_mode::parity)));
+}
+
+TEST_CASE("carver flood", "[voxelize]") {
+    // A box with a hole two voxels wide in one corner of its lid, and a ball and a bar inside, for the carver to find its way around
+    mesh m{};
+    m.add(test::box({ 0.75f, 0.75f, 0.75f }, { 14.25f, 14.25f, 2.25f }), { 0, 0, 0 });
+    m.add(test::box({ 0.75f, 0.75f, 2.25f }, { 2.25f, 14.25f, 16.25f }), { 0, 0, 0 });
+    m.add(test::box({ 12.75f, 0.75f, 2.25f }, { 14.25f, 14.25f, 16.25f }), { 0, 0, 0 });
+    m.add(test::box({ 2.25f, 0.75f, 2.25f }, { 12.75f, 2.25f, 16.25f }), { 0, 0, 0 });
+    m.add(test::box({ 2.25f, 12.75f, 2.25f }, { 12.75f, 14.25f, 16.25f }), { 0, 0, 0 });
+    m.add(test::box({ 5.25f, 2.25f, 14.75f }, { 12.75f, 12.75f, 16.25f }), { 0, 0, 0 });
+    m.add(test::box({ 2.25f, 5.25f, 14.75f }, { 5.25f, 12.75f, 16.25f }), { 0, 0, 0 });
+    m.add(test::sphere({ 5.5f, 8.5f, 7.5f }, 2.6f), { 0, 0, 0 });
+    m.add(test::box({ 9.25f, 3.75f, 4.25f }, { 10.75f, 11.25f, 5.75f }), { 0, 0, 0 });
+    const util::mdarray<Bool, 3> surface = surface_of(m, { 16, 16, 18 });
+
+    // The carver floods along runs rather than one position at a time, but reaches the same voxels
+    int volumes[5] = {};
+    for (const int carver_size : { 1, 2, 3, 4 }) {
+        util::mdarray<Bool, 3> solid(16, 16, 18);
+        fill_surface(m, surface, solid, carver_size, fill_mode::convex);
+        CHECK(differences(solid, reference_convex_fill(surface, carver_size)) == 0);
+        volumes[carver_size] = count(solid);
+    }
+    // Only carvers which fit through the hole empty the box
+    CHECK(volumes[2] + 500 < volumes[3]);
+    CHECK(volumes[3] == volumes[4]);
+}
+
+TEST_CASE("carver sweeps", "[voxelize]") {
+    // Scattered surface voxels, on a grid with a different size along each axis, leave gaps of every shape for the carver to test.
+    // The convex fill never looks at the mesh itself, so these need not come from one.
+    std::mt19937 random(12345);
+    for (const double density : { 0.02, 0.05, 0.1 }) {
+        util::mdarray<Bool, 3> surface(17, 13, 15);
+        std::bernoulli_distribution covered(density);
+        for (std::size_t x = 0; x != surface.extent(0); ++x) {
+            for (std::size_t y = 0; y != surface.extent(1); ++y) {
+                for (std::size_t z = 0; z != surface.extent(2); ++z) {
+                    surface[x, y, z] = covered(random);
+                }
+            }
+        }
+        for (const int carver_size : { 1, 2, 3, 4 }) {
+            util::mdarray<Bool, 3> solid(17, 13, 15);
+            fill_surface(mesh{}, surface, solid, carver_size, fill_mode::convex);
+            CHECK(differences(solid, reference_convex_fill(surface, carver_size)) == 0);
+        }
+    }
+}
+
+TEST_CASE("rotate solid", "[voxelize]") {
+    // A lopsided part, so that every cubic rotation of it is different
+    mesh base{};
+    base.add(test::box({ 0, 0, 0 }, { 9.3f, 2.6f, 3.1f }), { 0, 0, 0 });
+    base.add(test::box({ 0, 2.6f, 0 }, { 2.8f, 6.7f, 3.1f }), { 0, 0, 0 });
+    base.add(test::sphere({ 6.1f, 4.2f, 6.4f }, 3.3f), { 0, 0, 0 });
+    base.set_baseline({ 0, 0, 0 });
+    const geo::vector3<int> size = base.bounding().box_size;
+    const util::mdarray<Bool, 3> solid = solid_of(base, size, 1, fill_mode::convex);
+
+    // Rotating the voxels gives exactly what voxelizing the rotated part does, once it is moved by the returned offset
+    for (const geo::matrix3<float>& rotation : cubic_rotations) {
+        const geo::matrix3<int> exact = { (int)std::lround(rotation.xx), (int)std::lround(rotation.xy), (int)std::lround(rotation.xz),
+                                          (int)std::lround(rotation.yx), (int)std::lround(rotation.yy), (int)std::lround(rotation.yz),
+                                          (int)std::lround(rotation.zx), (int)std::lround(rotation.zy), (int)std::lround(rotation.zz) };
+        const geo::vector3<int> turned = exact * size;
+        const geo::vector3<int> rotated_size = { std::abs(turned.x), std::abs(turned.y), std::abs(turned.z) };
+        util::mdarray<Bool, 3> rotated(rotated_size.x, rotated_size.y, rotated_size.z);
+        const geo::vector3<int> shift = rotate_solid(solid, rotated, exact);
+
+        const geo::matrix3<float> exact_f = { (float)exact.xx, (float)exact.xy, (float)exact.xz,
+                                              (float)exact.yx, (float)exact.yy, (float)exact.yz,
+                                              (float)exact.zx, (float)exact.zy, (float)exact.zz };
+        mesh turned_mesh = base;
+        turned_mesh.rotate(exact_f);
+        mesh moved{};
+        moved.add(turned_mesh, { (float)shift.x, (float)shift.y, (float)shift.z });
+        CHECK(count(rotated) == count(solid));
+        CHECK(differences(rotated, solid_of(moved, rotated_size, 1, fill_mode::convex)) == 0);
+    }
+}
+
+TEST_CASE("resampler", "[voxelize]") {
+    // Keep every rotation of the part as the stacker does, for how far the resampled voxels may reach past those of the rotated part
+    const auto check = [](const mesh& part, const int factor, const bool convex) {
+        mesh fine_mesh{};
+        const mesh::transformed_t fine_transformed = part.transform_into(fine_mesh, factor, geo::eye3<float>, { 0, 0, 0 });
+        const resampler sampler(solid_of(fine_mesh, fine_transformed.bounding.box_size, factor, fill_mode::convex), factor);
+
+        for (const geo::matrix3<float>& rotation : arbitrary_rotations) {
+            mesh m{};
+            const mesh::transformed_t transformed = part.transform_into(m, 1, rotation, { 0, 0, 0 });
+            // Resampled voxels can reach one voxel further than the mesh itself
+            const geo::vector3<int> size = transformed.bounding.box_size + geo::vector3<int>{ 1, 1, 1 };
+            util::mdarray<Bool, 3> resampled(size.x, size.y, size.z);
+            sampler.resample(rotation, transformed.offset - rotation * fine_transformed.offset / (float)factor, resampled);
+
+            // Never drops a voxel which voxelizing the rotated part covers.
+            // The carver fits into other places on the finer grid, so only for a convex part do the resampled voxels
+            // also keep within one voxel of those.
+            const util::mdarray<Bool, 3> direct = solid_of(m, size, 1, fill_mode::convex);
+            const auto near_direct = [&](const int x, const int y, const int z) {
+                for (int i = std::max(x - 1, 0); i <= std::min(x + 1, size.x - 1); ++i) {
+                    for (int j = std::max(y - 1, 0); j <= std::min(y + 1, size.y - 1); ++j) {
+                        for (int k = std::max(z - 1, 0); k <= std::min(z + 1, size.z - 1); ++k) {
+                            if (direct[i, j, k]) {
+                                return true;
+                            }
+                        }
+                    }
+                }
+                return false;
+            };
+            int dropped = 0;
+            int stray = 0;
+            for (int x = 0; x != size.x; ++x) {
+                for (int y = 0; y != size.y; ++y) {
+                    for (int z = 0; z != size.z; ++z) {
+                        dropped += direct[x, y, z] and not resampled[x, y, z];
+                        stray += resampled[x, y, z] and not near_direct(x, y, z);
+                    }
+                }
+            }
+            CHECK(dropped == 0);
+            if (convex) {
+                CHECK(stray == 0);
+            }
+        }
+    };
+
+    mesh lopsided{};
+    lopsided.add(test::box({ 0, 0, 0 }, { 9.3f, 2.6f, 3.1f }), { 0, 0, 0 });
+    lopsided.add(test::sphere({ 6.1f, 4.2f, 6.4f }, 3.3f), { 0, 0, 0 });
+    for (const int factor : { 2, 3 }) {
+        check(lopsided, factor, false);
+        check(test::box({ 0, 0, 0 }, { 9.3f, 2.6f, 3.1f }), factor, true);
+        check(test::sphere({ 0, 0, 0 }, 4.7f), factor, true);
+    }
+}
+
+TEST_CASE("dilate", "[voxelize]") {
+    // Deeper than one word of bits, and not a whole number of bricks along any axis
+    std::mt19937 random(2024);
+    for (const geo::vector3<int> size : { geo::vector3<int>{ 9, 7, 130 }, geo::vector3<int>{ 21, 19, 64 }, geo::vector3<int>{ 3, 40, 65 } }) {
+        for (const double density : { 0.01, 0.2, 0.9 }) {
+            util::mdarray<Bool, 3> solid(size.x, size.y, size.z);
+            std::bernoulli_distribution covered(density);
+            for (int x = 0; x != size.x; ++x) {
+                for (int y = 0; y != size.y; ++y) {
+                    for (int z = 0; z != size.z; ++z) {
+                        solid[x, y, z] = covered(random);
+                    }
+                }
+            }
+
+            // One voxel at a time, as the stacker first expanded them: each voxel but the last along each axis
+            // marks the seven voxels ahead of it, so that what a part takes up reaches half a voxel past it on every side
+            util::mdarray<Bool, 3> expected(size.x, size.y, size.z);
+            for (int x = 0; x + 1 < size.x; ++x) {
+                for (int y = 0; y + 1 < size.y; ++y) {
+                    for (int z = 0; z + 1 < size.z; ++z) {
+                        if (solid[x, y, z]) {
+                            for (const auto [i, j, k] : { std::tuple{ 1, 1, 1 }, { 1, 1, 0 }, { 1, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 }, { 0, 1, 1 }, { 0, 0, 1 } }) {
+                                expected[x + i, y + j, z + k] = true;
+                            }
+                        }
+                    }
+                }
+            }
+
+            // Other bits are left alone, and the volume counts only the bit being marked
+            util::brick_grid<int> voxels(size.x, size.y, size.z);
+            voxels.element(0, 0, 0) |= 4;
+            voxels.element(size.x - 1, size.y - 1, size.z - 1) |= 4;
+            const int volume = dilate(solid, voxels, 2);
+            int different = 0;
+            for (int x = 0; x != size.x; ++x) {
+                for (int y = 0; y != size.y; ++y) {
+                    for (int z = 0; z != size.z; ++z) {
+                        different += ((voxels.at(x, y, z) & 2) != 0) != expected[x, y, z];
+                    }
+                }
+            }
+            CHECK(different == 0);
+            CHECK(volume == count(expected));
+            CHECK((voxels.at(0, 0, 0) & 4) != 0);
+            CHECK((voxels.at(size.x - 1, size.y - 1, size.z - 1) & 4) != 0);
+        }
+    }
+}
+
+} // namespace
+} // namespace pstack::calc
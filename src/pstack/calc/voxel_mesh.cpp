@@ -0,0 +1,104 @@
+#include "pstack/calc/voxel_mesh.hpp"
+#include "pstack/util/parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace pstack::calc {
+
+namespace {
+
+bool covered(const util::mdspan<const Bool, 3> voxels, const std::array<int, 3>& p) {
+#if defined(MDSPAN_USE_BRACKET_OPERATOR) and MDSPAN_USE_BRACKET_OPERATOR == 0
+    return voxels(p[0], p[1], p[2]);
+#else
+    return voxels[p[0], p[1], p[2]];
+#endif
+}
+
+} // namespace
+
+mesh voxel_mesh(const util::mdspan<const Bool, 3> voxels, const geo::point3<float> origin, const float size) {
+    const std::array<int, 3> extent = { (int)voxels.extent(0), (int)voxels.extent(1), (int)voxels.extent(2) };
+    const std::array<float, 3> start = { origin.x - size / 2, origin.y - size / 2, origin.z - size / 2 }; // The lowest corner of the first voxel
+
+    std::vector<geo::triangle> triangles{};
+    for (int axis = 0; axis != 3; ++axis) {
+        const int u_axis = (axis + 1) % 3;
+        const int v_axis = (axis + 2) % 3;
+        const int width = extent[u_axis];
+        const int height = extent[v_axis];
+
+        // Each plane between two layers of voxels is meshed on its own, so the planes are spread over the threads
+        std::vector<std::vector<geo::triangle>> planes(extent[axis] + 1);
+        util::parallel_for(planes.size(), [&](const int plane) {
+            // Which way the face between the voxels on either side of the plane points, if there is a face at all
+            std::vector<std::int8_t> facing(static_cast<std::size_t>(width) * height);
+            std::array<int, 3> p{};
+            for (int v = 0; v < height; ++v) {
+                for (int u = 0; u < width; ++u) {
+                    p[u_axis] = u;
+                    p[v_axis] = v;
+                    p[axis] = plane - 1;
+                    const bool behind = plane > 0 and covered(voxels, p);
+                    p[axis] = plane;
+                    const bool ahead = plane < extent[axis] and covered(voxels, p);
+                    facing[v * width + u] = behind == ahead ? 0 : behind ? 1 : -1;
+                }
+            }
+
+            const auto corner = [&](const int u, const int v) {
+                std::array<float, 3> c = start;
+                c[axis] += plane * size;
+                c[u_axis] += u * size;
+                c[v_axis] += v * size;
+                return geo::point3<float>{ c[0], c[1], c[2] };
+            };
+
+            // Grow each face as far as it goes along u, and then along v for as long as the whole row of faces points the same way
+            for (int v = 0; v < height; ++v) {
+                for (int u = 0; u < width; ++u) {
+                    const std::int8_t sign = facing[v * width + u];
+                    if (sign == 0) {
+                        continue;
+                    }
+                    int u_end = u + 1;
+                    while (u_end < width and facing[v * width + u_end] == sign) {
+                        ++u_end;
+                    }
+                    int v_end = v + 1;
+                    while (v_end < height and std::all_of(facing.data() + v_end * width + u, facing.data() + v_end * width + u_end, [&](const std::int8_t f) { return f == sign; })) {
+                        ++v_end;
+                    }
+                    for (int row = v; row < v_end; ++row) {
+                        std::fill(facing.data() + row * width + u, facing.data() + row * width + u_end, 0);
+                    }
+
+                    // Counter-clockwise seen from outside, which is the order of u then v on the positive side
+                    std::array<float, 3> n{};
+                    n[axis] = sign;
+                    const geo::vector3<float> normal = { n[0], n[1], n[2] };
+                    const geo::point3<float> c00 = corner(u, v);
+                    const geo::point3<float> c10 = corner(u_end, v);
+                    const geo::point3<float> c11 = corner(u_end, v_end);
+                    const geo::point3<float> c01 = corner(u, v_end);
+                    if (sign > 0) {
+                        planes[plane].push_back({ normal, c00, c10, c11 });
+                        planes[plane].push_back({ normal, c00, c11, c01 });
+                    } else {
+                        planes[plane].push_back({ normal, c00, c11, c10 });
+                        planes[plane].push_back({ normal, c00, c01, c11 });
+                    }
+                }
+            }
+        });
+
+        for (const std::vector<geo::triangle>& faces : planes) {
+            triangles.insert(triangles.end(), faces.begin(), faces.end());
+        }
+    }
+    return mesh(std::move(triangles));
+}
+
+} // namespace pstack::calc
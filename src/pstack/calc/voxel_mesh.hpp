@@ -0,0 +1,17 @@
+#ifndef PSTACK_CALC_VOXEL_MESH_HPP
+#define PSTACK_CALC_VOXEL_MESH_HPP
+
+#include "pstack/calc/bool.hpp"
+#include "pstack/calc/mesh.hpp"
+#include "pstack/geo/point3.hpp"
+#include "pstack/util/mdarray.hpp"
+
+namespace pstack::calc {
+
+// The surface of the covered voxels, with the voxel at `(i, j, k)` being a cube of side `size` centred on `origin + (i, j, k) * size`.
+// Only faces between a covered and an uncovered voxel are kept, and neighbouring faces in the same plane are merged into rectangles.
+mesh voxel_mesh(util::mdspan<const Bool, 3> voxels, geo::point3<float> origin, float size);
+
+} // namespace pstack::calc
+
+#endif // PSTACK_CALC_VOXEL_MESH_HPP
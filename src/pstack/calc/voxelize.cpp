@@ -1,211 +1,881 @@
 #include "pstack/calc/bool.hpp"
 #include "pstack/calc/voxelize.hpp"
 #include "pstack/util/mdarray.hpp"
+#include "pstack/util/parallel.hpp"
 #include <algorithm>
+#include <bit>
 #include <cfenv>
 #include <cmath>
-#include <span>
-#include <stack>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 namespace pstack::calc {
 
-int voxelize(const mesh& mesh, const util::mdspan<int, 3> voxels, const int index, const std::size_t carver_size) {
-    util::mdarray<Bool, 3> actual_triangles(voxels.extents());
-    util::mdarray<Bool, 3> visited(voxels.extents());
-    util::mdarray<Bool, 3> carved(voxels.extents());
+namespace {
 
-    // First render each part, placing voxels at the position of each triangle
-    for (const geo::triangle& t : mesh.triangles()) {
-        const geo::vector3 a = t.v1.as_vector();
-        const geo::vector3 b = t.v2 - t.v1;
-        const geo::vector3 c = t.v3 - t.v1;
+// Separating axis test between a voxel and a triangle, given relative to the centre of the voxel.
+// Triangles only visit the voxels within their bounding box, so the axes of the box itself can never separate the two.
+bool overlaps_voxel(const geo::vector3<float> v1, const geo::vector3<float> v2, const geo::vector3<float> v3, const geo::vector3<float> normal) {
+    constexpr float half = 0.5f;
+    const auto project = [&](const geo::vector3<float> axis) {
+        const float p1 = geo::dot(axis, v1);
+        const float p2 = geo::dot(axis, v2);
+        const float p3 = geo::dot(axis, v3);
+        const float r = half * (std::abs(axis.x) + std::abs(axis.y) + std::abs(axis.z));
+        return std::tuple{ std::min({ p1, p2, p3 }), std::max({ p1, p2, p3 }), r };
+    };
 
-        // Approximate the step size
-        const auto db = 0.1 / std::max({ std::abs(b.x), std::abs(b.y), std::abs(b.z) });
-        const auto dc = 0.1 / std::max({ std::abs(c.x), std::abs(c.y), std::abs(c.z) });
+    // A triangle lying exactly on the face between two voxels should mark both of them, rather than neither
+    if (const auto [min, max, r] = project(normal); min > r or max < -r) {
+        return false;
+    }
+
+    // The edges crossed with each axis of the voxel, where merely touching an edge or corner of the voxel does not count
+    const auto separated = [&](const geo::vector3<float> axis) {
+        const auto [min, max, r] = project(axis);
+        return r > 0 and (min >= r or max <= -r);
+    };
+    for (const geo::vector3<float> edge : { v2 - v1, v3 - v2, v1 - v3 }) {
+        if (separated(geo::cross(edge, geo::unit_x<float>)) or separated(geo::cross(edge, geo::unit_y<float>)) or separated(geo::cross(edge, geo::unit_z<float>))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The voxels whose extent of `[i - 0.5, i + 0.5]` touches `[min, max]`
+std::size_t first_voxel(const float min) {
+    return static_cast<std::size_t>(std::max(0.0f, std::ceil(min - 0.5f)));
+}
+std::size_t last_voxel(const float max) {
+    return static_cast<std::size_t>(max + 0.5f);
+}
 
-        // Voxelize
-        for (float p = 0; p < 1; p += db) {
-            for (float q = 0; q < 1 - p; q += dc) {
-                const geo::vector3 pos = a + p * b + q * c;
-                // Round to the nearest integer
-                // This is a hot path, so `std::round()`, `std::nearbyint()`, `std::floor()` are much slower
-                const auto x = static_cast<std::size_t>(pos.x + 0.5f);
-                const auto y = static_cast<std::size_t>(pos.y + 0.5f);
-                const auto z = static_cast<std::size_t>(pos.z + 0.5f);
-                actual_triangles[x, y, z] = true;
+// Marks every voxel with z in `[begin_z, end_z)` which the triangle passes through
+void rasterize(const geo::triangle& t, const util::mdspan<Bool, 3> voxels, const std::size_t begin_z, const std::size_t end_z) {
+    const auto [min_x, max_x] = std::minmax({ t.v1.x, t.v2.x, t.v3.x });
+    const auto [min_y, max_y] = std::minmax({ t.v1.y, t.v2.y, t.v3.y });
+    const auto [min_z, max_z] = std::minmax({ t.v1.z, t.v2.z, t.v3.z });
+    const geo::vector3 normal = geo::cross(t.v2 - t.v1, t.v3 - t.v1);
+
+    const std::size_t last_x = std::min(last_voxel(max_x) + 1, voxels.extent(0));
+    const std::size_t last_y = std::min(last_voxel(max_y) + 1, voxels.extent(1));
+    const std::size_t last_z = std::min(last_voxel(max_z) + 1, end_z);
+    for (std::size_t x = first_voxel(min_x); x < last_x; ++x) {
+        for (std::size_t y = first_voxel(min_y); y < last_y; ++y) {
+            for (std::size_t z = std::max(first_voxel(min_z), begin_z); z < last_z; ++z) {
+#if defined(MDSPAN_USE_BRACKET_OPERATOR) and MDSPAN_USE_BRACKET_OPERATOR == 0
+                Bool& voxel = voxels(x, y, z);
+#else
+                Bool& voxel = voxels[x, y, z];
+#endif
+                if (voxel) {
+                    continue;
+                }
+                const geo::vector3<float> centre = { (float)x, (float)y, (float)z };
+                if (overlaps_voxel(t.v1.as_vector() - centre, t.v2.as_vector() - centre, t.v3.as_vector() - centre, normal)) {
+                    voxel = true;
+                }
             }
         }
     }
+}
 
-    if (carver_size > 0) {
-        std::stack<geo::point3<int>> stack{};
+constexpr float at(const geo::point3<float>& p, const int axis) {
+    return axis == 0 ? p.x : axis == 1 ? p.y : p.z;
+}
 
-        // Carving step
-        for (int x = 0; x < voxels.extent(0); ++x) {
-            for (int y = 0; y < voxels.extent(1); ++y) {
-                for (int z = 0; z < voxels.extent(2); ++z) {
-                    if (x == 0 || y == 0 || z == 0 || x == voxels.extent(0) - carver_size || y == voxels.extent(1) - carver_size || z == voxels.extent(2) - carver_size) {
-#if defined(__cpp_aggregate_paren_init) and __cpp_aggregate_paren_init >= 201902L
-                        stack.emplace(x, y, z);
+// Casts a ray along `axis` through the centre of every line of voxels, and adds a vote to each voxel
+// which the ray reaches after crossing the surface an odd number of times.
+// The lines are worked on in parallel by their position along the next axis, so each only ever writes to its own voxels.
+void cast_rays(const mesh& mesh, const util::mdspan<std::uint8_t, 3> votes, const int axis) {
+    const int u = (axis + 1) % 3;
+    const int v = (axis + 2) % 3;
+    const std::size_t extent[3] = { votes.extent(0), votes.extent(1), votes.extent(2) };
+
+    // Nudge every ray slightly off the voxel centres, so that they do not pass exactly through vertices and edges
+    constexpr float nudge_u = 0.00123f;
+    constexpr float nudge_v = 0.00257f;
+
+    std::vector<std::vector<std::uint32_t>> rows(extent[u]);
+    for (std::size_t index = 0; index != mesh.triangle_count(); ++index) {
+        const geo::triangle t = mesh.triangle(index);
+        const auto [min_u, max_u] = std::minmax({ at(t.v1, u), at(t.v2, u), at(t.v3, u) });
+        const std::size_t last_u = std::min<std::size_t>(std::max(0.0f, std::floor(max_u - nudge_u)), extent[u] - 1);
+        for (std::size_t i = static_cast<std::size_t>(std::max(0.0f, std::ceil(min_u - nudge_u))); i <= last_u; ++i) {
+            rows[i].push_back(static_cast<std::uint32_t>(index));
+        }
+    }
+
+    util::parallel_for(extent[u], [&](const std::size_t i) {
+        const float pu = i + nudge_u;
+        std::vector<std::vector<float>> crossings(extent[v]);
+        for (const std::uint32_t index : rows[i]) {
+            const geo::triangle t = mesh.triangle(index);
+            const float u1 = at(t.v1, u), u2 = at(t.v2, u), u3 = at(t.v3, u);
+            const float v1 = at(t.v1, v), v2 = at(t.v2, v), v3 = at(t.v3, v);
+            const float area = (u2 - u1) * (v3 - v1) - (u3 - u1) * (v2 - v1);
+            if (area == 0) {
+                continue; // Seen edge-on, so the ray can only graze it
+            }
+            const auto [min_v, max_v] = std::minmax({ v1, v2, v3 });
+            const std::size_t last_v = std::min<std::size_t>(std::max(0.0f, std::floor(max_v - nudge_v)), extent[v] - 1);
+            for (std::size_t j = static_cast<std::size_t>(std::max(0.0f, std::ceil(min_v - nudge_v))); j <= last_v; ++j) {
+                const float pv = j + nudge_v;
+                const float w1 = ((u2 - pu) * (v3 - pv) - (u3 - pu) * (v2 - pv)) / area;
+                const float w2 = ((u3 - pu) * (v1 - pv) - (u1 - pu) * (v3 - pv)) / area;
+                const float w3 = 1 - w1 - w2;
+                if (w1 >= 0 and w2 >= 0 and w3 >= 0) {
+                    crossings[j].push_back(w1 * at(t.v1, axis) + w2 * at(t.v2, axis) + w3 * at(t.v3, axis));
+                }
+            }
+        }
+
+        for (std::size_t j = 0; j != extent[v]; ++j) {
+            std::ranges::sort(crossings[j]);
+            std::size_t crossed = 0;
+            for (std::size_t k = 0; k != extent[axis]; ++k) {
+                while (crossed != crossings[j].size() and crossings[j][crossed] < k) {
+                    ++crossed;
+                }
+                if (crossed % 2 == 1) {
+                    std::size_t position[3];
+                    position[axis] = k;
+                    position[u] = i;
+                    position[v] = j;
+#if defined(MDSPAN_USE_BRACKET_OPERATOR) and MDSPAN_USE_BRACKET_OPERATOR == 0
+                    ++votes(position[0], position[1], position[2]);
 #else
-                        stack.push(geo::point3<int>{x, y, z});
+                    ++votes[position[0], position[1], position[2]];
 #endif
-                    }
                 }
             }
         }
+    });
+}
 
-        while (not stack.empty()) {
-            const auto [x, y, z] = stack.top();
-            stack.pop();
+// The grid is split into slabs along z, which are worked on in parallel.
+// Each slab only ever writes to its own voxels, though it may read from the slabs next to it.
+struct slab_split {
+    int depth;
+    int thickness;
+    int count;
+
+    explicit slab_split(const int depth)
+        : depth(depth)
+        , thickness(std::max<int>(1, (depth + util::thread_count() - 1) / util::thread_count()))
+        , count((depth + thickness - 1) / thickness)
+    {}
+
+    int begin(const int slab) const {
+        return slab * thickness;
+    }
+    int end(const int slab) const {
+        return std::min(depth, (slab + 1) * thickness);
+    }
+};
 
-            // Check if we need to do work here
-            if (x < 0 || y < 0 || z < 0 || x > voxels.extent(0) - carver_size || y > voxels.extent(1) - carver_size || z > voxels.extent(2) - carver_size || visited[x, y, z]) {
-                continue;
+// The scratch grids used while voxelizing, kept for each thread between calls until `release_scratch_grids`,
+// so that voxelizing every rotation of a part does not allocate them over and over
+struct scratch_grids {
+    util::mdarray<Bool, 3> carved;
+    util::mdarray<std::uint8_t, 3> flags; // The bits below while carving, and the votes of the rays after
+    util::mdarray<Bool, 3> solid;
+    std::vector<std::uint64_t> columns;
+    util::mdarray<int, 3> distances;
+};
+
+scratch_grids& thread_scratch_grids() {
+    thread_local scratch_grids grids{};
+    return grids;
+}
+
+// The bits of `scratch_grids::flags` while carving
+constexpr std::uint8_t blocked = 1; // The carver would overlap the surface here
+constexpr std::uint8_t visited = 2; // The carver has already been tested here
+constexpr std::uint8_t reached = 4; // The carver reaches here from outside
+
+// The squared distance of a voxel which no part voxel reaches along the lines transformed so far
+constexpr int far_away = std::numeric_limits<int>::max();
+
+// Transforms one line of squared distances, `stride` apart, so that each becomes the least `line[q] + max(|p - q| - 1, 0)^2`.
+// That is the squared distance between the cubes of the voxels rather than between their centres, and comes from spreading each value
+// to its neighbours first, and then taking the lower envelope of the parabolas `line[q] + (p - q)^2` [Felzenszwalb & Huttenlocher].
+void transform_line(int* const line, const std::ptrdiff_t stride, const int length, std::vector<int>& values, std::vector<int>& roots, std::vector<double>& bounds) {
+    values.resize(length);
+    roots.resize(length);
+    bounds.resize(length);
+    for (int p = 0; p < length; ++p) {
+        int value = line[p * stride];
+        if (p > 0) {
+            value = std::min(value, line[(p - 1) * stride]);
+        }
+        if (p + 1 < length) {
+            value = std::min(value, line[(p + 1) * stride]);
+        }
+        values[p] = value;
+    }
+
+    // Each parabola is kept from where it drops below the ones before it, and those it hides completely are dropped
+    int count = 0;
+    for (int q = 0; q < length; ++q) {
+        if (values[q] == far_away) {
+            continue;
+        }
+        double start = -std::numeric_limits<double>::infinity();
+        while (count > 0) {
+            const int r = roots[count - 1];
+            start = ((values[q] + static_cast<double>(q) * q) - (values[r] + static_cast<double>(r) * r)) / (2.0 * (q - r));
+            if (start > bounds[count - 1]) {
+                break;
             }
-            visited[x, y, z] = true;
+            --count;
+            start = -std::numeric_limits<double>::infinity();
+        }
+        roots[count] = q;
+        bounds[count] = start;
+        ++count;
+    }
 
-            const bool good = [&] {
-                for (std::size_t i = 0; i < carver_size; ++i) {
-                    for (std::size_t j = 0; j < carver_size; ++j) {
-                        for (std::size_t k = 0; k < carver_size; ++k) {
-                            if (actual_triangles[x + i, y + j, z + k]) {
-                                return false;
-                            }
-                        }
+    for (int p = 0, j = 0; p < length; ++p) {
+        if (count == 0) {
+            line[p * stride] = far_away;
+            continue;
+        }
+        while (j + 1 < count and bounds[j + 1] < p) {
+            ++j;
+        }
+        const int r = roots[j];
+        line[p * stride] = values[r] + (p - r) * (p - r);
+    }
+}
+
+} // namespace
+
+void voxelize_surface(const mesh& mesh, const util::mdspan<Bool, 3> surface) {
+    std::fill_n(surface.data_handle(), surface.size(), false);
+    const int depth = surface.extent(2);
+    const slab_split slabs(depth);
+
+    // Each slab renders the triangles which reach into it, so the threads never write to the same voxel
+    std::vector<std::vector<std::uint32_t>> bins(slabs.count);
+    for (std::size_t index = 0; index != mesh.triangle_count(); ++index) {
+        const geo::triangle t = mesh.triangle(index);
+        const auto [min_z, max_z] = std::minmax({ t.v1.z, t.v2.z, t.v3.z });
+        const int last_slab = std::min<int>(last_voxel(max_z), depth - 1) / slabs.thickness;
+        for (int slab = first_voxel(min_z) / slabs.thickness; slab <= last_slab; ++slab) {
+            bins[slab].push_back(static_cast<std::uint32_t>(index));
+        }
+    }
+    util::parallel_for(slabs.count, [&](const int slab) {
+        for (const std::uint32_t index : bins[slab]) {
+            rasterize(mesh.triangle(index), surface, slabs.begin(slab), slabs.end(slab));
+        }
+    });
+}
+
+namespace {
+
+// Turns the surface in `solid` into the solid part in place, as `fill_surface` describes.
+// Without a carver there is nothing to fill, and the surface is left as it is.
+void fill_in_place(const mesh& mesh, const util::mdspan<Bool, 3> solid, const std::size_t carver_size, const fill_mode fill) {
+    if (carver_size == 0) {
+        return;
+    }
+    const auto voxel = [&](const std::size_t x, const std::size_t y, const std::size_t z) -> Bool& {
+#if defined(MDSPAN_USE_BRACKET_OPERATOR) and MDSPAN_USE_BRACKET_OPERATOR == 0
+        return solid(x, y, z);
+#else
+        return solid[x, y, z];
+#endif
+    };
+
+    // Both grids are written in full before they are read, so they are only resized
+    scratch_grids& scratch = thread_scratch_grids();
+    util::mdarray<Bool, 3>& carved = scratch.carved;
+    util::mdarray<std::uint8_t, 3>& flags = scratch.flags;
+    carved.resize(solid.extents());
+    flags.resize(solid.extents());
+
+    const int depth = solid.extent(2);
+    const slab_split slabs(depth);
+
+    // Carving step
+    // The carver floods whole runs of positions along z at a time, and each run scans the columns beside it for the runs it reaches.
+    // Each slab floods its own voxels, and hands any run which crosses into the slab below or above over to the next round.
+    const int last_x = static_cast<int>(solid.extent(0)) - static_cast<int>(carver_size);
+    const int last_y = static_cast<int>(solid.extent(1)) - static_cast<int>(carver_size);
+    const int last_z = static_cast<int>(solid.extent(2)) - static_cast<int>(carver_size);
+
+    // Which positions of the carver would overlap the surface.
+    // The carver is a box, so the surface is swept back along z, then y, then x, each time keeping track of the nearest surface ahead.
+    // `carved` is only used as scratch space here, and is written in full once carving is done.
+    util::parallel_for(slabs.count, [&](const int slab) {
+        const int top_z = std::min<int>(depth, slabs.end(slab) + carver_size - 1);
+        for (int x = 0; x < solid.extent(0); ++x) {
+            for (int y = 0; y < solid.extent(1); ++y) {
+                int nearest = std::numeric_limits<int>::max() / 2;
+                for (int z = top_z - 1; z >= slabs.begin(slab); --z) {
+                    if (voxel(x, y, z)) {
+                        nearest = z;
+                    }
+                    if (z < slabs.end(slab)) {
+                        flags[x, y, z] = nearest - z < carver_size ? blocked : 0;
                     }
                 }
-                return true;
-            }();
-            if (not good) {
-                continue;
             }
-
-            for (std::size_t i = 0; i < carver_size; ++i) {
-                for (std::size_t j = 0; j < carver_size; ++j) {
-                    for (std::size_t k = 0; k < carver_size; ++k) {
-                        carved[x + i, y + j, z + k] = true;
+        }
+    });
+    util::parallel_for(slabs.count, [&](const int slab) {
+        const int begin_z = slabs.begin(slab);
+        const int end_z = slabs.end(slab);
+        std::vector<int> nearest_y(end_z - begin_z);
+        std::vector<int> nearest_x(solid.extent(1) * (end_z - begin_z), std::numeric_limits<int>::max() / 2);
+        for (int x = 0; x < solid.extent(0); ++x) {
+            std::ranges::fill(nearest_y, std::numeric_limits<int>::max() / 2);
+            for (int y = solid.extent(1) - 1; y >= 0; --y) {
+                for (int z = begin_z; z < end_z; ++z) {
+                    if (flags[x, y, z] & blocked) {
+                        nearest_y[z - begin_z] = y;
+                    }
+                    carved[x, y, z] = nearest_y[z - begin_z] - y < carver_size;
+                }
+            }
+        }
+        for (int x = solid.extent(0) - 1; x >= 0; --x) {
+            for (int y = 0; y < solid.extent(1); ++y) {
+                for (int z = begin_z; z < end_z; ++z) {
+                    int& nearest = nearest_x[y * (end_z - begin_z) + z - begin_z];
+                    if (carved[x, y, z]) {
+                        nearest = x;
                     }
+                    flags[x, y, z] = nearest - x < carver_size ? blocked : 0;
                 }
             }
+        }
+    });
 
-#if defined(__cpp_aggregate_paren_init) and __cpp_aggregate_paren_init >= 201902L
-            stack.emplace(x - 1, y, z);
-            stack.emplace(x + 1, y, z);
+    // Whether the carver newly reaches this position, so that each position is only ever tested once
+    const auto reach = [&](const int x, const int y, const int z) {
+        std::uint8_t& flag = flags[x, y, z];
+        if (flag & visited) {
+            return false;
+        }
+        flag |= visited;
+        return not (flag & blocked);
+    };
 
-            stack.emplace(x, y - 1, z);
-            stack.emplace(x, y + 1, z);
+    struct run {
+        int x;
+        int y;
+        int begin;
+        int end;
+    };
+    std::vector<std::vector<geo::point3<int>>> seeds(slabs.count);
+    std::vector<std::vector<geo::point3<int>>> handed_below(slabs.count);
+    std::vector<std::vector<geo::point3<int>>> handed_above(slabs.count);
+    for (int x = 0; x <= last_x; ++x) {
+        for (int y = 0; y <= last_y; ++y) {
+            for (int z = 0; z <= last_z; ++z) {
+                if (x == 0 || y == 0 || z == 0 || x == last_x || y == last_y || z == last_z) {
+                    seeds[z / slabs.thickness].push_back({ x, y, z });
+                }
+            }
+        }
+    }
 
-            stack.emplace(x, y, z - 1);
-            stack.emplace(x, y, z + 1);
-#else
-            stack.push(geo::point3<int>{x - 1, y, z});
-            stack.push(geo::point3<int>{x + 1, y, z});
+    while (std::ranges::any_of(seeds, [](const auto& s) { return not s.empty(); })) {
+        util::parallel_for(slabs.count, [&](const int slab) {
+            const int begin_z = slabs.begin(slab);
+            const int end_z = std::min(slabs.end(slab), last_z + 1);
+            std::vector<run> runs{};
+            for (const auto [x, y, z] : seeds[slab]) {
+                if (reach(x, y, z)) {
+                    runs.push_back({ x, y, z, z + 1 });
+                }
+            }
+            seeds[slab].clear();
 
-            stack.push(geo::point3<int>{x, y - 1, z});
-            stack.push(geo::point3<int>{x, y + 1, z});
+            while (not runs.empty()) {
+                auto [x, y, begin, end] = runs.back();
+                runs.pop_back();
 
-            stack.push(geo::point3<int>{x, y, z - 1});
-            stack.push(geo::point3<int>{x, y, z + 1});
-#endif
-        }
+                // Grow the run as far as it goes within this slab
+                while (begin > begin_z and reach(x, y, begin - 1)) {
+                    --begin;
+                }
+                while (end < end_z and reach(x, y, end)) {
+                    ++end;
+                }
+                if (begin == begin_z and begin > 0) {
+                    handed_below[slab].push_back({ x, y, begin - 1 });
+                }
+                if (end == slabs.end(slab) and end <= last_z) {
+                    handed_above[slab].push_back({ x, y, end });
+                }
+                for (int z = begin; z < end; ++z) {
+                    flags[x, y, z] |= reached;
+                }
 
-        // #region convexivy
+                for (const auto [nx, ny] : { std::pair{ x - 1, y }, std::pair{ x + 1, y }, std::pair{ x, y - 1 }, std::pair{ x, y + 1 } }) {
+                    if (nx < 0 || ny < 0 || nx > last_x || ny > last_y) {
+                        continue;
+                    }
+                    bool open = false;
+                    for (int z = begin; z < end; ++z) {
+                        if (not reach(nx, ny, z)) {
+                            open = false;
+                        } else if (open) {
+                            ++runs.back().end;
+                        } else {
+                            runs.push_back({ nx, ny, z, z + 1 });
+                            open = true;
+                        }
+                    }
+                }
+            }
+        });
 
-        // Make convex in z-direction
-        for (int x = 0; x < voxels.extent(0); ++x) {
-            for (int y = 0; y < voxels.extent(1); ++y) {
-                int minV = std::numeric_limits<int>::max();
-                int maxV = std::numeric_limits<int>::min();
+        for (int slab = 0; slab != slabs.count; ++slab) {
+            if (slab != 0) {
+                seeds[slab - 1].insert(seeds[slab - 1].end(), handed_below[slab].begin(), handed_below[slab].end());
+            }
+            if (slab != slabs.count - 1) {
+                seeds[slab + 1].insert(seeds[slab + 1].end(), handed_above[slab].begin(), handed_above[slab].end());
+            }
+            handed_below[slab].clear();
+            handed_above[slab].clear();
+        }
+    }
 
-                for (int z = 0; z < voxels.extent(2); ++z) {
-                    if (actual_triangles[x, y, z]) {
-                        minV = std::min(z, minV);
-                        maxV = std::max(z, maxV);
+    // Everything covered by the carver at any position it reached is carved away.
+    // The carver is a box, so it is swept along z, then y, then x, each time keeping track of the nearest position it reached.
+    // The sweep along z reads the slabs below its own, so it writes to `carved`, which no slab reads, rather than to the flags.
+    util::parallel_for(slabs.count, [&](const int slab) {
+        for (int x = 0; x < solid.extent(0); ++x) {
+            for (int y = 0; y < solid.extent(1); ++y) {
+                int nearest = std::numeric_limits<int>::min() / 2;
+                for (int z = std::max<int>(0, slabs.begin(slab) - carver_size + 1); z < slabs.end(slab); ++z) {
+                    if (flags[x, y, z] & reached) {
+                        nearest = z;
+                    }
+                    if (z >= slabs.begin(slab)) {
+                        carved[x, y, z] = z - nearest < carver_size;
+                    }
+                }
+            }
+        }
+    });
+    util::parallel_for(slabs.count, [&](const int slab) {
+        const int begin_z = slabs.begin(slab);
+        const int end_z = slabs.end(slab);
+        std::vector<int> nearest_y(end_z - begin_z);
+        std::vector<int> nearest_x(solid.extent(1) * (end_z - begin_z), std::numeric_limits<int>::min() / 2);
+        for (int x = 0; x < solid.extent(0); ++x) {
+            std::ranges::fill(nearest_y, std::numeric_limits<int>::min() / 2);
+            for (int y = 0; y < solid.extent(1); ++y) {
+                for (int z = begin_z; z < end_z; ++z) {
+                    if (carved[x, y, z]) {
+                        nearest_y[z - begin_z] = y;
                     }
+                    flags[x, y, z] = y - nearest_y[z - begin_z] < carver_size ? reached : 0;
                 }
+            }
+        }
+        for (int x = 0; x < solid.extent(0); ++x) {
+            for (int y = 0; y < solid.extent(1); ++y) {
+                for (int z = begin_z; z < end_z; ++z) {
+                    int& nearest = nearest_x[y * (end_z - begin_z) + z - begin_z];
+                    if (flags[x, y, z] & reached) {
+                        nearest = x;
+                    }
+                    carved[x, y, z] = x - nearest < carver_size;
+                }
+            }
+        }
+    });
+
+    // #region convexivy
 
-                for (int z = minV; z < maxV; z++) {
-                    actual_triangles[x, y, z] = true;
+    // Make convex in z-direction
+    util::parallel_for(solid.extent(0), [&](const int x) {
+        for (int y = 0; y < solid.extent(1); ++y) {
+            int minV = std::numeric_limits<int>::max();
+            int maxV = std::numeric_limits<int>::min();
+
+            for (int z = 0; z < solid.extent(2); ++z) {
+                if (voxel(x, y, z)) {
+                    minV = std::min(z, minV);
+                    maxV = std::max(z, maxV);
                 }
             }
+
+            for (int z = minV; z < maxV; z++) {
+                voxel(x, y, z) = true;
+            }
         }
+    });
 
-        // Make convex in y-direction
-        for (int x = 0; x < voxels.extent(0); ++x) {
-            for (int z = 0; z < voxels.extent(2); ++z) {
+    // Make convex in y-direction
+    util::parallel_for(slabs.count, [&](const int slab) {
+        for (int x = 0; x < solid.extent(0); ++x) {
+            for (int z = slabs.begin(slab); z < slabs.end(slab); ++z) {
                 int minV = std::numeric_limits<int>::max();
                 int maxV = std::numeric_limits<int>::min();
 
-                for (int y = 0; y < voxels.extent(1); ++y) {
-                    if (actual_triangles[x, y, z]) {
+                for (int y = 0; y < solid.extent(1); ++y) {
+                    if (voxel(x, y, z)) {
                         minV = std::min(y, minV);
                         maxV = std::max(y, maxV);
                     }
                 }
 
                 for (int y = minV; y < maxV; y++) {
-                    actual_triangles[x, y, z] = true;
+                    voxel(x, y, z) = true;
                 }
             }
         }
+    });
 
-        // Make convex in x-direction
-        for (int z = 0; z < voxels.extent(2); ++z) {
-            for (int y = 0; y < voxels.extent(1); ++y) {
+    // Make convex in x-direction
+    util::parallel_for(slabs.count, [&](const int slab) {
+        for (int z = slabs.begin(slab); z < slabs.end(slab); ++z) {
+            for (int y = 0; y < solid.extent(1); ++y) {
                 int minV = std::numeric_limits<int>::max();
                 int maxV = std::numeric_limits<int>::min();
 
-                for (int x = 0; x < voxels.extent(0); ++x) {
-                    if (actual_triangles[x, y, z]) {
+                for (int x = 0; x < solid.extent(0); ++x) {
+                    if (voxel(x, y, z)) {
                         minV = std::min(x, minV);
                         maxV = std::max(x, maxV);
                     }
                 }
 
                 for (int x = minV; x < maxV; x++) {
-                    actual_triangles[x, y, z] = true;
+                    voxel(x, y, z) = true;
                 }
             }
         }
+    });
 
-        // #endregion
+    // #endregion
+
+    // The parity fill also keeps whatever rays along at least two of the three axes find inside the surface,
+    // so that a hole in the mesh which lets the carver in does not hollow out the part, while one bad ray does not flood a whole line.
+    // The flags are done with once carving is, so they count the votes.
+    const bool parity = fill == fill_mode::parity;
+    util::mdarray<std::uint8_t, 3>& votes = flags;
+    if (parity) {
+        votes.assign(solid.extents(), 0);
+        for (int axis = 0; axis != 3; ++axis) {
+            cast_rays(mesh, votes, axis);
+        }
     }
 
-    // Expand by one voxel in all directions
-    for (std::size_t x = 0; x < voxels.extent(0) - 1; ++x) {
-        for (std::size_t y = 0; y < voxels.extent(1) - 1; ++y) {
-            for (std::size_t z = 0; z < voxels.extent(2) - 1; ++z) {
-                if (not carved[x, y, z] and actual_triangles[x, y, z]) {
+    // Whatever the carver reached is left out, unless the rays find it inside
+    util::parallel_for(slabs.count, [&](const int slab) {
+        for (std::size_t x = 0; x < solid.extent(0); ++x) {
+            for (std::size_t y = 0; y < solid.extent(1); ++y) {
+                for (int z = slabs.begin(slab); z < slabs.end(slab); ++z) {
+                    Bool& filled = voxel(x, y, z);
+                    filled = (not carved[x, y, z] and filled) or (parity and votes[x, y, z] >= 2);
+                }
+            }
+        }
+    });
+}
+
+} // namespace
+
+void fill_surface(const mesh& mesh, const util::mdspan<const Bool, 3> surface, const util::mdspan<Bool, 3> solid, const std::size_t carver_size, const fill_mode fill) {
+    std::copy_n(surface.data_handle(), surface.size(), solid.data_handle());
+    fill_in_place(mesh, solid, carver_size, fill);
+}
+
+void voxelize_solid(const mesh& mesh, const util::mdspan<Bool, 3> solid, const std::size_t carver_size, const fill_mode fill) {
+    voxelize_surface(mesh, solid);
+    fill_in_place(mesh, solid, carver_size, fill);
+}
+
+void release_scratch_grids() {
+    thread_scratch_grids() = {};
+}
+
+int dilate(const util::mdspan<const Bool, 3> solid, util::brick_grid<int>& voxels, const int index) {
+    const int width = voxels.extent(0);
+    const int length = voxels.extent(1);
+    const int depth = voxels.extent(2);
+    const int words = (depth + 63) / 64;
+
+    // Pack each column along z into bits, one word for every 64 voxels.
+    // The last voxel along each axis is left out, since expanding it would reach past the grid.
+    std::vector<std::uint64_t>& columns = thread_scratch_grids().columns;
+    columns.assign(static_cast<std::size_t>(width) * length * words, 0);
+    const auto column = [&](const int x, const int y) {
+        return columns.data() + (static_cast<std::size_t>(x) * length + y) * words;
+    };
+    util::parallel_for(std::max(width - 1, 0), [&](const int x) {
+        for (int y = 0; y < length - 1; ++y) {
+            std::uint64_t* const c = column(x, y);
+            for (int z = 0; z < depth - 1; ++z) {
 #if defined(MDSPAN_USE_BRACKET_OPERATOR) and MDSPAN_USE_BRACKET_OPERATOR == 0
-                    voxels(x + 1, y + 1, z + 1) |= index;
-                    voxels(x + 1, y + 1, z) |= index;
-                    voxels(x + 1, y, z + 1) |= index;
-                    voxels(x + 1, y, z) |= index;
-                    voxels(x, y + 1, z) |= index;
-                    voxels(x, y + 1, z + 1) |= index;
-                    voxels(x, y, z + 1) |= index;
+                if (solid(x, y, z)) {
 #else
-                    voxels[x + 1, y + 1, z + 1] |= index;
-                    voxels[x + 1, y + 1, z] |= index;
-                    voxels[x + 1, y, z + 1] |= index;
-                    voxels[x + 1, y, z] |= index;
-                    voxels[x, y + 1, z] |= index;
-                    voxels[x, y + 1, z + 1] |= index;
-                    voxels[x, y, z + 1] |= index;
+                if (solid[x, y, z]) {
 #endif
+                    c[z / 64] |= std::uint64_t{ 1 } << (z % 64);
+                }
+            }
+        }
+    });
+
+    // Expand by one voxel in all directions, which is shifting up along z and OR-ing in the columns behind in x and y.
+    // Each voxel marks the seven voxels ahead of it, though not itself.
+    // Every thread takes a whole slab of bricks along x, so no two threads ever store the same brick,
+    // and compacts the slab once it is done, so that only the bricks on the surface of the part stay stored.
+    constexpr int brick_size = util::brick_grid<int>::brick_size;
+    std::vector<int> volumes(voxels.bricks(0));
+    util::parallel_for(volumes.size(), [&](const int bx) {
+        std::vector<std::uint64_t> behind(words);
+        std::vector<std::uint64_t> expanded(words);
+        for (int x = bx * brick_size; x < std::min(width, (bx + 1) * brick_size); ++x) {
+            for (int y = 0; y < length; ++y) {
+                const std::uint64_t* const self = column(x, y);
+                const std::uint64_t* const back_x = x > 0 ? column(x - 1, y) : nullptr;
+                const std::uint64_t* const back_y = y > 0 ? column(x, y - 1) : nullptr;
+                const std::uint64_t* const back_xy = x > 0 and y > 0 ? column(x - 1, y - 1) : nullptr;
+                for (int w = 0; w < words; ++w) {
+                    behind[w] = (back_x ? back_x[w] : 0) | (back_y ? back_y[w] : 0) | (back_xy ? back_xy[w] : 0);
+                }
+                for (int w = 0; w < words; ++w) {
+                    const std::uint64_t carry = w > 0 ? ((behind[w - 1] | self[w - 1]) >> 63) : 0;
+                    expanded[w] = behind[w] | ((behind[w] | self[w]) << 1) | carry;
+                }
+
+                for (int w = 0; w < words; ++w) {
+                    volumes[bx] += std::popcount(expanded[w]);
+                    for (std::uint64_t bits = expanded[w]; bits != 0; bits &= bits - 1) {
+                        const int z = w * 64 + std::countr_zero(bits);
+                        voxels.element(x, y, z) |= index;
+                    }
+                }
+            }
+        }
+        voxels.compact(bx);
+    });
+
+    // The bit `index` is new to every voxel, so the volume is the number of bits set here
+    return std::reduce(volumes.begin(), volumes.end());
+}
+
+int mark(const util::mdspan<const Bool, 3> solid, util::brick_grid<int>& voxels, const int index) {
+    constexpr int brick_size = util::brick_grid<int>::brick_size;
+    const int width = voxels.extent(0);
+    std::vector<int> volumes(voxels.bricks(0));
+    util::parallel_for(volumes.size(), [&](const int bx) {
+        for (int x = bx * brick_size; x < std::min(width, (bx + 1) * brick_size); ++x) {
+            for (int y = 0; y < voxels.extent(1); ++y) {
+                for (int z = 0; z < voxels.extent(2); ++z) {
+#if defined(MDSPAN_USE_BRACKET_OPERATOR) and MDSPAN_USE_BRACKET_OPERATOR == 0
+                    if (solid(x, y, z)) {
+#else
+                    if (solid[x, y, z]) {
+#endif
+                        voxels.element(x, y, z) |= index;
+                        ++volumes[bx];
+                    }
+                }
+            }
+        }
+        voxels.compact(bx);
+    });
+    return std::reduce(volumes.begin(), volumes.end());
+}
+
+int clearance_margin(const double gap) {
+    return static_cast<int>(std::ceil(gap));
+}
+
+void dilate(const util::mdspan<const Bool, 3> solid, util::brick_grid<int>& voxels, const int index, const double gap) {
+    const int margin = clearance_margin(gap);
+    const int width = voxels.extent(0);
+    const int length = voxels.extent(1);
+    const int depth = voxels.extent(2);
+
+    // Start from zero on the part and far away everywhere else, then transform along z, y, and x in turn.
+    // Each pass only mixes values along its own lines, so the lines of each pass are spread over the threads.
+    util::mdarray<int, 3>& distances = thread_scratch_grids().distances;
+    distances.resize(voxels.extents());
+    util::parallel_for(width, [&](const int x) {
+        std::vector<int> values, roots;
+        std::vector<double> bounds;
+        for (int y = 0; y < length; ++y) {
+            for (int z = 0; z < depth; ++z) {
+                const int sx = x - margin;
+                const int sy = y - margin;
+                const int sz = z - margin;
+                const bool inside = sx >= 0 and sy >= 0 and sz >= 0 and sx < solid.extent(0) and sy < solid.extent(1) and sz < solid.extent(2);
+#if defined(MDSPAN_USE_BRACKET_OPERATOR) and MDSPAN_USE_BRACKET_OPERATOR == 0
+                distances[x, y, z] = inside and solid(sx, sy, sz) ? 0 : far_away;
+#else
+                distances[x, y, z] = inside and solid[sx, sy, sz] ? 0 : far_away;
+#endif
+            }
+            transform_line(&distances[x, y, 0], 1, depth, values, roots, bounds);
+        }
+        for (int z = 0; z < depth; ++z) {
+            transform_line(&distances[x, 0, z], depth, length, values, roots, bounds);
+        }
+    });
+    util::parallel_for(length, [&](const int y) {
+        std::vector<int> values, roots;
+        std::vector<double> bounds;
+        for (int z = 0; z < depth; ++z) {
+            transform_line(&distances[0, y, z], static_cast<std::ptrdiff_t>(length) * depth, width, values, roots, bounds);
+        }
+    });
+
+    // Every thread takes a whole slab of bricks along x, so no two threads ever store the same brick, and compacts it once it is done
+    constexpr int brick_size = util::brick_grid<int>::brick_size;
+    util::parallel_for(voxels.bricks(0), [&](const int bx) {
+        for (int x = bx * brick_size; x < std::min(width, (bx + 1) * brick_size); ++x) {
+            for (int y = 0; y < length; ++y) {
+                for (int z = 0; z < depth; ++z) {
+                    if (distances[x, y, z] < gap * gap) {
+                        voxels.element(x, y, z) |= index;
+                    }
+                }
+            }
+        }
+        voxels.compact(bx);
+    });
+}
+
+geo::vector3<int> rotate_solid(const util::mdspan<const Bool, 3> solid, const util::mdspan<Bool, 3> rotated, const geo::matrix3<int>& rotation) {
+    const geo::vector3<int> size = { (int)solid.extent(0), (int)solid.extent(1), (int)solid.extent(2) };
+    const geo::vector3<int> turned = rotation * size;
+    const geo::vector3<int> offset = { turned.x < 0 ? -turned.x - 2 : 0, turned.y < 0 ? -turned.y - 2 : 0, turned.z < 0 ? -turned.z - 2 : 0 };
+
+    // Every voxel lands somewhere different, so the threads never write to the same voxel
+    util::parallel_for(size.x, [&](const int x) {
+        for (int y = 0; y < size.y; ++y) {
+            for (int z = 0; z < size.z; ++z) {
+#if defined(MDSPAN_USE_BRACKET_OPERATOR) and MDSPAN_USE_BRACKET_OPERATOR == 0
+                if (not solid(x, y, z)) {
+                    continue;
+                }
+                const geo::vector3<int> p = rotation * geo::vector3<int>{ x, y, z } + offset;
+                if (p.x >= 0 and p.y >= 0 and p.z >= 0) {
+                    rotated(p.x, p.y, p.z) = true;
+                }
+#else
+                if (not solid[x, y, z]) {
+                    continue;
+                }
+                const geo::vector3<int> p = rotation * geo::vector3<int>{ x, y, z } + offset;
+                if (p.x >= 0 and p.y >= 0 and p.z >= 0) {
+                    rotated[p.x, p.y, p.z] = true;
+                }
+#endif
+            }
+        }
+    });
+    return offset;
+}
+
+resampler::resampler(const util::mdspan<const Bool, 3> fine, const int factor)
+    : _fine(fine.extents())
+    , _factor(factor)
+{
+    for (std::size_t x = 0; x < fine.extent(0); ++x) {
+        for (std::size_t y = 0; y < fine.extent(1); ++y) {
+            for (std::size_t z = 0; z < fine.extent(2); ++z) {
+#if defined(MDSPAN_USE_BRACKET_OPERATOR) and MDSPAN_USE_BRACKET_OPERATOR == 0
+                _fine[x, y, z] = fine(x, y, z);
+#else
+                _fine[x, y, z] = fine[x, y, z];
+#endif
+            }
+        }
+    }
+
+    // Only the fine voxels with an uncovered neighbour can reach past the inside of the part
+    for (int x = 0; x < _fine.extent(0); ++x) {
+        for (int y = 0; y < _fine.extent(1); ++y) {
+            for (int z = 0; z < _fine.extent(2); ++z) {
+                if (not covered(x, y, z)) {
+                    continue;
+                }
+                if (not covered(x - 1, y, z) or not covered(x + 1, y, z)
+                    or not covered(x, y - 1, z) or not covered(x, y + 1, z)
+                    or not covered(x, y, z - 1) or not covered(x, y, z + 1))
+                {
+                    _boundary.push_back({ x, y, z });
+                }
+            }
+        }
+    }
+}
+
+void resampler::resample(const geo::matrix3<float>& rotation, const geo::vector3<float> translation, const util::mdspan<Bool, 3> resampled) const {
+    const auto mark = [&](const std::size_t x, const std::size_t y, const std::size_t z) -> Bool& {
+#if defined(MDSPAN_USE_BRACKET_OPERATOR) and MDSPAN_USE_BRACKET_OPERATOR == 0
+        return resampled(x, y, z);
+#else
+        return resampled[x, y, z];
+#endif
+    };
+
+    // Each fine voxel on the boundary is a box of `1 / factor` on each side, and is covered by the bounding box of that box once it is turned
+    const float half = 0.5f / _factor;
+    const geo::vector3<float> reach = {
+        half * (std::abs(rotation.xx) + std::abs(rotation.xy) + std::abs(rotation.xz)),
+        half * (std::abs(rotation.yx) + std::abs(rotation.yy) + std::abs(rotation.yz)),
+        half * (std::abs(rotation.zx) + std::abs(rotation.zy) + std::abs(rotation.zz)),
+    };
+    for (const auto [x, y, z] : _boundary) {
+        const geo::vector3<float> centre = rotation * (geo::vector3<float>{ (float)x, (float)y, (float)z } / (float)_factor) + translation;
+        const std::size_t last_x = std::min(last_voxel(centre.x + reach.x) + 1, resampled.extent(0));
+        const std::size_t last_y = std::min(last_voxel(centre.y + reach.y) + 1, resampled.extent(1));
+        const std::size_t last_z = std::min(last_voxel(centre.z + reach.z) + 1, resampled.extent(2));
+        for (std::size_t i = first_voxel(centre.x - reach.x); i < last_x; ++i) {
+            for (std::size_t j = first_voxel(centre.y - reach.y); j < last_y; ++j) {
+                for (std::size_t k = first_voxel(centre.z - reach.z); k < last_z; ++k) {
+                    mark(i, j, k) = true;
                 }
             }
         }
     }
 
-    // Calculate and return volume by counting the voxels
-    const std::span<const int> all_voxels{ voxels.data_handle(), voxels.size() };
-    return std::ranges::count_if(all_voxels, [index](int i) {
-        return (i & index) != 0;
+    // Any voxel the boundary does not reach lies either wholly inside or wholly outside, so its centre decides which
+    const geo::matrix3<float> inverse = { rotation.xx, rotation.yx, rotation.zx,
+                                          rotation.xy, rotation.yy, rotation.zy,
+                                          rotation.xz, rotation.yz, rotation.zz };
+    // Each voxel only depends on its own centre, so every thread takes its own slices along x.
+    const geo::vector3<float> step = inverse * geo::vector3<float>{ 0, 0, (float)_factor };
+    util::parallel_for(resampled.extent(0), [&](const std::size_t i) {
+        for (std::size_t j = 0; j < resampled.extent(1); ++j) {
+            geo::vector3<float> p = inverse * (geo::vector3<float>{ (float)i, (float)j, 0 } - translation) * (float)_factor;
+            for (std::size_t k = 0; k < resampled.extent(2); ++k, p = p + step) {
+                Bool& voxel = mark(i, j, k);
+                if (not voxel and p.x > -0.5f and p.y > -0.5f and p.z > -0.5f and covered(p.x + 0.5f, p.y + 0.5f, p.z + 0.5f)) {
+                    voxel = true;
+                }
+            }
+        }
     });
 }
 
+int voxelize(const mesh& mesh, util::brick_grid<int>& voxels, const int index, const std::size_t carver_size, const fill_mode fill) {
+    util::mdarray<Bool, 3>& solid = thread_scratch_grids().solid;
+    solid.resize(voxels.extents());
+    voxelize_solid(mesh, solid, carver_size, fill);
+    return dilate(solid, voxels, index);
+}
+
 } // namespace pstack::calc
@@ -1,12 +1,83 @@
 #ifndef PSTACK_CALC_VOXELIZE_HPP
 #define PSTACK_CALC_VOXELIZE_HPP
 
+#include "pstack/calc/bool.hpp"
 #include "pstack/calc/mesh.hpp"
+#include "pstack/geo/matrix3.hpp"
+#include "pstack/geo/point3.hpp"
+#include "pstack/geo/vector3.hpp"
+#include "pstack/util/brick_grid.hpp"
+#include "pstack/util/layout_tiled.hpp"
 #include "pstack/util/mdarray.hpp"
+#include <vector>
 
 namespace pstack::calc {
 
-int voxelize(const mesh& mesh, util::mdspan<int, 3> voxels, int index, std::size_t carver_size);
+// How the inside of a part is filled in, once its surface has been rendered
+enum class fill_mode {
+    convex, // Every line along each axis is filled between its outermost surface voxels, except where the carver reaches from outside
+    parity, // As convex, but also keeps whatever rays along the axes find inside the surface, so that a hole in the mesh does not let the carver hollow it out
+};
+
+// Marks every voxel which a triangle of the part passes through
+void voxelize_surface(const mesh& mesh, util::mdspan<Bool, 3> surface);
+
+// Marks every voxel which the part covers, being its `surface` and whatever `fill` fills in of its inside.
+// Only the surface depends on rendering the triangles, so a part can be filled again with another `carver_size` from the same surface.
+void fill_surface(const mesh& mesh, util::mdspan<const Bool, 3> surface, util::mdspan<Bool, 3> solid, std::size_t carver_size, fill_mode fill);
+
+// Both of the above in one go
+void voxelize_solid(const mesh& mesh, util::mdspan<Bool, 3> solid, std::size_t carver_size, fill_mode fill);
+
+// Voxelizing keeps scratch grids for each thread between calls, as large as the largest part that thread has voxelized.
+// Frees those of the calling thread, for when it has finished voxelizing but lives on.
+void release_scratch_grids();
+
+// Expands the voxels covered in `solid` by one voxel, marking them with the bit `index` in `voxels`, and returns the volume of the result.
+// Each voxel but the last along each axis marks the seven voxels ahead of it towards +x, +y, and +z, though not itself,
+// so the result reaches half a voxel past the part on every side once the part is moved by half a voxel.
+int dilate(util::mdspan<const Bool, 3> solid, util::brick_grid<int>& voxels, int index);
+
+// Marks the voxels covered in `solid` with the bit `index` in `voxels`, as they are, and returns how many there are
+int mark(util::mdspan<const Bool, 3> solid, util::brick_grid<int>& voxels, int index);
+
+// How many voxels past the part itself a clearance of `gap` voxels reaches
+int clearance_margin(double gap);
+
+// Marks every voxel which lies less than `gap` voxels from the part covered in `solid` with the bit `index` in `voxels`,
+// measured exactly between the cubes of the voxels by a separable Euclidean distance transform, in time linear in the grid.
+// `voxels` reaches `clearance_margin(gap)` voxels past `solid` on every side.
+void dilate(util::mdspan<const Bool, 3> solid, util::brick_grid<int>& voxels, int index, double gap);
+
+// Marks the voxels covered in `solid` in `rotated` as well, turned by `rotation`, which must only swap and flip the axes.
+// Along each flipped axis, the voxels keep their distance from the far side of the part's bounding box rather than from zero,
+// and the returned offset is what moves the rotated mesh back onto them.
+geo::vector3<int> rotate_solid(util::mdspan<const Bool, 3> solid, util::mdspan<Bool, 3> rotated, const geo::matrix3<int>& rotation);
+
+// A part voxelized on a grid `factor` times finer, from which any rotation of it can be resampled without voxelizing it again
+class resampler {
+public:
+    resampler(util::mdspan<const Bool, 3> fine, int factor);
+
+    // Marks every voxel of `resampled` which any covered fine voxel reaches, once turned by `rotation` and then moved by `translation`.
+    // Nothing the fine voxels cover is ever missed, so the result only ever grows compared with voxelizing the rotated part.
+    void resample(const geo::matrix3<float>& rotation, geo::vector3<float> translation, util::mdspan<Bool, 3> resampled) const;
+
+private:
+    // Looked up at turned positions, which step across the grid in every direction at once rather than along z
+    util::mdarray<Bool, 3, util::layout_tiled<8>> _fine;
+    int _factor;
+    std::vector<geo::point3<int>> _boundary{};
+
+    bool covered(const int x, const int y, const int z) const {
+        if (x < 0 or y < 0 or z < 0 or x >= _fine.extent(0) or y >= _fine.extent(1) or z >= _fine.extent(2)) {
+            return false;
+        }
+        return _fine[x, y, z];
+    }
+};
+
+int voxelize(const mesh& mesh, util::brick_grid<int>& voxels, int index, std::size_t carver_size, fill_mode fill);
 
 } // namespace pstack::calc
 
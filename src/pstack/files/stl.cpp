@@ -2,6 +2,7 @@
 #include "pstack/files/stl.hpp"
 #include "pstack/geo/triangle.hpp"
 #include <array>
+#include <cstddef>
 #include <fstream>
 #include <ranges>
 #include <sstream>
@@ -9,10 +10,10 @@
 
 namespace pstack::files {
 
-calc::mesh from_stl(const std::string& file_path) {
+void from_stl(const std::string& file_path, const std::function<void(std::size_t)>& reserve, const std::function<void(const geo::triangle&)>& push_back) {
     auto file_expected = read_file(file_path);
     if (not file_expected.has_value()) {
-        return {};
+        return;
     }
     std::string& file = *file_expected;
     const std::size_t file_size = file.size();
@@ -24,13 +25,12 @@ calc::mesh from_stl(const std::string& file_path) {
     std::uint32_t count;
     ss.read(reinterpret_cast<char*>(&count), sizeof(count));
 
-    std::vector<geo::triangle> triangles{};
-
     if (file_size == 84 + count * 50) { // Binary STL
+        reserve(count);
         char buffer[50];
         while (count-- != 0) {
             ss.read(buffer, sizeof(buffer));
-            triangles.push_back(*reinterpret_cast<geo::triangle*>(buffer));
+            push_back(*reinterpret_cast<geo::triangle*>(buffer));
         }
     } else { // ASCII STL
         // facet normal ni nj nk
@@ -70,16 +70,9 @@ calc::mesh from_stl(const std::string& file_path) {
             geo::point3<float> v1 = parse_point(lines[i + 2]);
             geo::point3<float> v2 = parse_point(lines[i + 3]);
             geo::point3<float> v3 = parse_point(lines[i + 4]);
-
-#if defined(__cpp_aggregate_paren_init) and __cpp_aggregate_paren_init >= 201902L
-            triangles.emplace_back(normal, v1, v2, v3);
-#else
-            triangles.push_back(geo::triangle{normal, v1, v2, v3});
-#endif
+            push_back(geo::triangle{normal, v1, v2, v3});
         }
     }
-
-    return calc::mesh(std::move(triangles));
 }
 
 void to_stl(const calc::mesh& mesh, const std::string& file_path) {
@@ -88,11 +81,12 @@ void to_stl(const calc::mesh& mesh, const std::string& file_path) {
     const std::array<std::byte, 80> header{};
     file.write(reinterpret_cast<const char*>(header.data()), header.size());
 
-    const std::uint32_t count = static_cast<std::uint32_t>(mesh.triangles().size());
+    const std::uint32_t count = static_cast<std::uint32_t>(mesh.triangle_count());
     file.write(reinterpret_cast<const char*>(&count), sizeof(count));
 
     std::array<std::byte, 50> triangle{};
-    for (const auto& t : mesh.triangles()) {
+    for (std::size_t i = 0; i != mesh.triangle_count(); ++i) {
+        const geo::triangle t = mesh.triangle(i);
         reinterpret_cast<float*>(triangle.data())[ 0] = t.normal.x;
         reinterpret_cast<float*>(triangle.data())[ 1] = t.normal.y;
         reinterpret_cast<float*>(triangle.data())[ 2] = t.normal.z;
@@ -2,11 +2,17 @@
 #define PSTACK_FILES_STL_HPP
 
 #include "pstack/calc/mesh.hpp"
+#include "pstack/geo/triangle.hpp"
+#include <cstddef>
+#include <functional>
 #include <string>
 
 namespace pstack::files {
 
-calc::mesh from_stl(const std::string& file_path);
+// Reads the triangles of an STL file one at a time and hands each to `push_back`, so that the caller can build them into a mesh
+// without the whole triangle soup ever being held. `reserve` is told how many triangles there are first, when the file says so.
+// Reads nothing from a file which cannot be opened.
+void from_stl(const std::string& file_path, const std::function<void(std::size_t)>& reserve, const std::function<void(const geo::triangle&)>& push_back);
 void to_stl(const calc::mesh& mesh, const std::string& file_path);
 
 } // namespace pstack::files
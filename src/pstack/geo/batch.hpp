@@ -0,0 +1,282 @@
+#ifndef PSTACK_GEO_BATCH_HPP
+#define PSTACK_GEO_BATCH_HPP
+
+#include "pstack/geo/matrix3.hpp"
+#include "pstack/geo/matrix4.hpp"
+#include "pstack/geo/point3.hpp"
+#include "pstack/geo/vector3.hpp"
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+// With GCC or Clang on x86, the float kernels are also built for AVX2, which is used if the processor has it.
+// Elsewhere they are only built for the instruction set the whole program targets, which is SSE2 on x64 and NEON on arm64.
+// AVX-512 is left out, as building for it lets the compiler fuse multiplies and adds, which would round differently.
+#if (defined(__GNUC__) or defined(__clang__)) and (defined(__x86_64__) or defined(__i386__))
+#define PSTACK_GEO_BATCH_DISPATCH 1
+#else
+#define PSTACK_GEO_BATCH_DISPATCH 0
+#endif
+
+namespace pstack::geo {
+
+// Many points or vectors, with each of their coordinates in its own span, all of the same length
+template <class T>
+struct span3 {
+    std::span<T> x;
+    std::span<T> y;
+    std::span<T> z;
+
+    constexpr std::size_t size() const {
+        return x.size();
+    }
+
+    constexpr operator span3<const T>() const requires (not std::is_const_v<T>) {
+        return { x, y, z };
+    }
+};
+
+template <class T>
+struct bounds3 {
+    point3<T> min;
+    point3<T> max;
+};
+
+namespace batch {
+
+// The kernels work through this many points side by side, which is two AVX2 registers of floats, or four of SSE2 or NEON.
+// Each point is computed exactly as the scalar operators would, and each reduction keeps one partial result per lane,
+// so the results never depend on which instruction set ran them.
+inline constexpr std::size_t lanes = 16;
+
+namespace detail {
+
+// Points worked out a block at a time into arrays which nothing else can alias, so that the compiler is free to keep them in vector registers.
+// They are only copied out to their spans once the whole block has been read.
+template <class T>
+struct block {
+    std::array<T, lanes> x;
+    std::array<T, lanes> y;
+    std::array<T, lanes> z;
+};
+
+// Calls `visit` with the first index and size of each block of `lanes` points in turn, and then of whatever is left over.
+// The size of the whole blocks is a compile-time constant, so that the loops over their lanes can be unrolled.
+template <class Visit>
+constexpr void for_each_block(const std::size_t count, Visit&& visit) {
+    const std::size_t whole = count - count % lanes;
+    for (std::size_t first = 0; first != whole; first += lanes) {
+        visit(first, std::integral_constant<std::size_t, lanes>{});
+    }
+    if (whole != count) {
+        visit(whole, count - whole);
+    }
+}
+
+// Each coordinate is copied on its own, as the spans could overlap for all the compiler knows,
+// and it could then only copy them one lane at a time to keep the writes to each of them in order
+template <class T>
+constexpr void store(const block<T>& from, const span3<T> to, const std::size_t first, const std::size_t size) {
+    for (std::size_t lane = 0; lane != size; ++lane) {
+        to.x[first + lane] = from.x[lane];
+    }
+    for (std::size_t lane = 0; lane != size; ++lane) {
+        to.y[first + lane] = from.y[lane];
+    }
+    for (std::size_t lane = 0; lane != size; ++lane) {
+        to.z[first + lane] = from.z[lane];
+    }
+}
+
+// The least and greatest of the values seen by each lane
+template <class T>
+struct lane_bounds {
+    block<T> min;
+    block<T> max;
+
+    constexpr lane_bounds() {
+        for (std::array<T, lanes>* m : { &min.x, &min.y, &min.z }) {
+            m->fill(std::numeric_limits<T>::max());
+        }
+        for (std::array<T, lanes>* m : { &max.x, &max.y, &max.z }) {
+            m->fill(std::numeric_limits<T>::lowest());
+        }
+    }
+
+    constexpr void add(const std::span<const T> x, const std::span<const T> y, const std::span<const T> z, const std::size_t first, const std::size_t size) {
+        for (std::size_t lane = 0; lane != size; ++lane) {
+            min.x[lane] = x[first + lane] < min.x[lane] ? x[first + lane] : min.x[lane];
+            min.y[lane] = y[first + lane] < min.y[lane] ? y[first + lane] : min.y[lane];
+            min.z[lane] = z[first + lane] < min.z[lane] ? z[first + lane] : min.z[lane];
+            max.x[lane] = x[first + lane] > max.x[lane] ? x[first + lane] : max.x[lane];
+            max.y[lane] = y[first + lane] > max.y[lane] ? y[first + lane] : max.y[lane];
+            max.z[lane] = z[first + lane] > max.z[lane] ? z[first + lane] : max.z[lane];
+        }
+    }
+
+    constexpr bounds3<T> combine() const {
+        bounds3<T> out = { { min.x[0], min.y[0], min.z[0] }, { max.x[0], max.y[0], max.z[0] } };
+        for (std::size_t lane = 1; lane != lanes; ++lane) {
+            out.min.x = min.x[lane] < out.min.x ? min.x[lane] : out.min.x;
+            out.min.y = min.y[lane] < out.min.y ? min.y[lane] : out.min.y;
+            out.min.z = min.z[lane] < out.min.z ? min.z[lane] : out.min.z;
+            out.max.x = max.x[lane] > out.max.x ? max.x[lane] : out.max.x;
+            out.max.y = max.y[lane] > out.max.y ? max.y[lane] : out.max.y;
+            out.max.z = max.z[lane] > out.max.z ? max.z[lane] : out.max.z;
+        }
+        return out;
+    }
+};
+
+// Writes `m * from[i]` to `to[i]`, and returns the bounds of what was written if `Bound` is set.
+// `m` is a copy, as the compiler would otherwise have to reload it after every write in case `to` overlaps it.
+template <bool Bound, class T>
+constexpr bounds3<T> linear(const span3<const T> from, const span3<T> to, const matrix3<T> m) {
+    lane_bounds<T> bounds{};
+    for_each_block(from.size(), [&](const std::size_t first, const auto size) {
+        block<T> out;
+        for (std::size_t lane = 0; lane != size; ++lane) {
+            const std::size_t i = first + lane;
+            out.x[lane] = (m.xx * from.x[i]) + (m.xy * from.y[i]) + (m.xz * from.z[i]);
+            out.y[lane] = (m.yx * from.x[i]) + (m.yy * from.y[i]) + (m.yz * from.z[i]);
+            out.z[lane] = (m.zx * from.x[i]) + (m.zy * from.y[i]) + (m.zz * from.z[i]);
+        }
+        if constexpr (Bound) {
+            bounds.add(out.x, out.y, out.z, 0, size);
+        }
+        store(out, to, first, size);
+    });
+    return bounds.combine();
+}
+
+template <class T>
+constexpr void affine(const span3<const T> from, const span3<T> to, const matrix4<T> m) {
+    for_each_block(from.size(), [&](const std::size_t first, const auto size) {
+        block<T> out;
+        for (std::size_t lane = 0; lane != size; ++lane) {
+            const std::size_t i = first + lane;
+            out.x[lane] = (m.xx * from.x[i]) + (m.xy * from.y[i]) + (m.xz * from.z[i]) + m.xw;
+            out.y[lane] = (m.yx * from.x[i]) + (m.yy * from.y[i]) + (m.yz * from.z[i]) + m.yw;
+            out.z[lane] = (m.zx * from.x[i]) + (m.zy * from.y[i]) + (m.zz * from.z[i]) + m.zw;
+        }
+        store(out, to, first, size);
+    });
+}
+
+template <class T>
+constexpr bounds3<T> bounds(const span3<const T> points) {
+    lane_bounds<T> bounds{};
+    for_each_block(points.size(), [&](const std::size_t first, const auto size) {
+        bounds.add(points.x, points.y, points.z, first, size);
+    });
+    return bounds.combine();
+}
+
+// The reductions only write to their own sums, so they can read straight from the spans without copying them first
+template <class T>
+constexpr T dot_sum(const span3<const T> lhs, const span3<const T> rhs) {
+    std::array<T, lanes> sums{};
+    for_each_block(lhs.size(), [&](const std::size_t first, const auto size) {
+        for (std::size_t lane = 0; lane != size; ++lane) {
+            const std::size_t i = first + lane;
+            sums[lane] += (lhs.x[i] * rhs.x[i]) + (lhs.y[i] * rhs.y[i]) + (lhs.z[i] * rhs.z[i]);
+        }
+    });
+    T out{};
+    for (const T sum : sums) {
+        out += sum;
+    }
+    return out;
+}
+
+template <class T>
+constexpr vector3<T> cross_sum(const span3<const T> lhs, const span3<const T> rhs) {
+    block<T> sums{};
+    for_each_block(lhs.size(), [&](const std::size_t first, const auto size) {
+        for (std::size_t lane = 0; lane != size; ++lane) {
+            const std::size_t i = first + lane;
+            sums.x[lane] += lhs.y[i] * rhs.z[i] - lhs.z[i] * rhs.y[i];
+            sums.y[lane] += lhs.z[i] * rhs.x[i] - lhs.x[i] * rhs.z[i];
+            sums.z[lane] += lhs.x[i] * rhs.y[i] - lhs.y[i] * rhs.x[i];
+        }
+    });
+    vector3<T> out{};
+    for (std::size_t lane = 0; lane != lanes; ++lane) {
+        out += vector3<T>{ sums.x[lane], sums.y[lane], sums.z[lane] };
+    }
+    return out;
+}
+
+#if PSTACK_GEO_BATCH_DISPATCH
+inline bool has_avx2() {
+    static const bool has = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return has;
+}
+
+// Everything the kernel calls is inlined, so that all of it is built for AVX2
+template <class Kernel>
+[[gnu::target("avx2"), gnu::flatten]] inline auto run_avx2(const Kernel& kernel) {
+    return kernel();
+}
+#endif
+
+template <class T, class Kernel>
+constexpr auto dispatch(const Kernel& kernel) {
+#if PSTACK_GEO_BATCH_DISPATCH
+    if constexpr (std::is_same_v<T, float>) {
+        if (not std::is_constant_evaluated() and has_avx2()) {
+            return run_avx2(kernel);
+        }
+    }
+#endif
+    return kernel();
+}
+
+} // namespace detail
+
+// Writes `m * from[i]` to each `to[i]`. `to` may be the same as `from`.
+template <class T>
+constexpr void transform(const std::type_identity_t<span3<const T>> from, const span3<T> to, const matrix3<T>& m) {
+    detail::dispatch<T>([&] { detail::linear<false>(from, to, m); });
+}
+
+// Writes each point of `from` moved by the affine transform `m` to `to`, which may be the same as `from`.
+// The last row of `m` is taken to be `0 0 0 1`.
+template <class T>
+constexpr void transform(const std::type_identity_t<span3<const T>> from, const span3<T> to, const matrix4<T>& m) {
+    detail::dispatch<T>([&] { detail::affine(from, to, m); });
+}
+
+// As `transform`, also returning the bounds of the points written, which saves reading them all again
+template <class T>
+constexpr bounds3<T> transform_bounds(const std::type_identity_t<span3<const T>> from, const span3<T> to, const matrix3<T>& m) {
+    return detail::dispatch<T>([&] { return detail::linear<true>(from, to, m); });
+}
+
+// The least and greatest of each coordinate, which are the greatest and least representable values if there are no points
+template <class T, class U = std::remove_const_t<T>>
+constexpr bounds3<U> bounds(const span3<T> points) {
+    return detail::dispatch<U>([&] { return detail::bounds<U>(points); });
+}
+
+// The sums of `dot(lhs[i], rhs[i])` and `cross(lhs[i], rhs[i])`, which each lane adds up separately
+template <class T, class U = std::remove_const_t<T>>
+constexpr U dot_sum(const span3<T> lhs, const std::type_identity_t<span3<T>> rhs) {
+    return detail::dispatch<U>([&] { return detail::dot_sum<U>(lhs, rhs); });
+}
+
+template <class T, class U = std::remove_const_t<T>>
+constexpr vector3<U> cross_sum(const span3<T> lhs, const std::type_identity_t<span3<T>> rhs) {
+    return detail::dispatch<U>([&] { return detail::cross_sum<U>(lhs, rhs); });
+}
+
+} // namespace batch
+
+} // namespace pstack::geo
+
+#endif // PSTACK_GEO_BATCH_HPP
@@ -0,0 +1,205 @@
+#include "pstack/geo/batch.hpp"
+#include "pstack/geo/test/generate.hpp"
+#include <catch2/catch_template_test_macros.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace pstack::geo {
+namespace {
+
+constexpr test::generator<> g{};
+using Catch::Matchers::WithinAbs;
+
+// Enough to fill every lane twice, with some left over
+constexpr std::size_t count = 2 * batch::lanes + 5;
+
+template <class T>
+struct points {
+    std::vector<T> x;
+    std::vector<T> y;
+    std::vector<T> z;
+
+    span3<T> span() {
+        return { x, y, z };
+    }
+    span3<const T> span() const {
+        return { x, y, z };
+    }
+    vector3<T> operator[](const std::size_t i) const {
+        return { x[i], y[i], z[i] };
+    }
+};
+
+// All from one generator, which would give the same values again if it were called twice in one test
+template <class T, std::size_t Sets = 1>
+std::array<points<T>, Sets> generate_points() {
+    const auto values = GENERATE(take(3, chunk(Sets * 3 * count, random(T{-1000}, T{1000}))));
+    std::array<points<T>, Sets> out{};
+    auto it = values.begin();
+    for (points<T>& p : out) {
+        for (std::vector<T>* coordinate : { &p.x, &p.y, &p.z }) {
+            coordinate->assign(it, it + count);
+            it += count;
+        }
+    }
+    return out;
+}
+
+template <class T>
+points<T> sized_like(const points<T>& p) {
+    return { std::vector<T>(p.x.size()), std::vector<T>(p.y.size()), std::vector<T>(p.z.size()) };
+}
+
+TEMPLATE_TEST_CASE("span3 conversion", "[batch]",
+                   int, long, double, float)
+{
+    using T = TestType;
+    STATIC_CHECK(std::is_convertible_v<span3<T>, span3<const T>>);
+    STATIC_CHECK(not std::is_convertible_v<span3<const T>, span3<T>>);
+}
+
+TEMPLATE_TEST_CASE("matrix3 transform()", "[batch]",
+                   int, long, double, float)
+{
+    using T = TestType;
+    const auto m = g.generate<matrix3<T>>();
+    const auto [from] = generate_points<T>();
+    points<T> to = sized_like(from);
+    batch::transform(from.span(), to.span(), m);
+    for (std::size_t i = 0; i != count; ++i) {
+        CHECK(to[i] == m * from[i]);
+    }
+
+    // In place
+    points<T> same = from;
+    batch::transform(same.span(), same.span(), m);
+    for (std::size_t i = 0; i != count; ++i) {
+        CHECK(same[i] == m * from[i]);
+    }
+}
+
+TEMPLATE_TEST_CASE("matrix4 transform()", "[batch]",
+                   int, long, double, float)
+{
+    using T = TestType;
+    const auto [rotation, translation] = g.generate<matrix3<T>, vector3<T>>();
+    const matrix4<T> m = { rotation.xx, rotation.xy, rotation.xz, translation.x,
+                           rotation.yx, rotation.yy, rotation.yz, translation.y,
+                           rotation.zx, rotation.zy, rotation.zz, translation.z,
+                                     0,           0,           0,             1 };
+    const auto [from] = generate_points<T>();
+    points<T> to = sized_like(from);
+    batch::transform(from.span(), to.span(), m);
+    for (std::size_t i = 0; i != count; ++i) {
+        CHECK(to[i] == (rotation * from[i]) + translation);
+    }
+}
+
+TEMPLATE_TEST_CASE("bounds()", "[batch]",
+                   int, long, double, float)
+{
+    using T = TestType;
+    const auto [p] = generate_points<T>();
+    const bounds3<T> actual = batch::bounds(p.span());
+    CHECK(actual.min == point3<T>{ std::ranges::min(p.x), std::ranges::min(p.y), std::ranges::min(p.z) });
+    CHECK(actual.max == point3<T>{ std::ranges::max(p.x), std::ranges::max(p.y), std::ranges::max(p.z) });
+
+    const bounds3<T> empty = batch::bounds(span3<const T>{});
+    CHECK(empty.min == point3<T>{ std::numeric_limits<T>::max(), std::numeric_limits<T>::max(), std::numeric_limits<T>::max() });
+    CHECK(empty.max == point3<T>{ std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest() });
+}
+
+TEMPLATE_TEST_CASE("transform_bounds()", "[batch]",
+                   int, long, double, float)
+{
+    using T = TestType;
+    const auto m = g.generate<matrix3<T>>();
+    const auto [from] = generate_points<T>();
+    points<T> to = sized_like(from);
+    const bounds3<T> actual = batch::transform_bounds(from.span(), to.span(), m);
+    for (std::size_t i = 0; i != count; ++i) {
+        CHECK(to[i] == m * from[i]);
+    }
+    const bounds3<T> expected = batch::bounds(to.span());
+    CHECK(actual.min == expected.min);
+    CHECK(actual.max == expected.max);
+}
+
+TEMPLATE_TEST_CASE("dot_sum()", "[batch]",
+                   int, long, double, float)
+{
+    using T = TestType;
+    const auto [lhs, rhs] = generate_points<T, 2>();
+    double expected = 0;
+    double magnitude = 0;
+    for (std::size_t i = 0; i != count; ++i) {
+        expected += dot(lhs[i], rhs[i]);
+        magnitude += std::abs(lhs[i].x * rhs[i].x) + std::abs(lhs[i].y * rhs[i].y) + std::abs(lhs[i].z * rhs[i].z);
+    }
+    const T actual = batch::dot_sum(lhs.span(), rhs.span());
+    if constexpr (std::integral<T>) {
+        CHECK(actual == expected);
+    } else {
+        CHECK_THAT(actual, WithinAbs(expected, magnitude * std::numeric_limits<T>::epsilon()));
+    }
+}
+
+TEMPLATE_TEST_CASE("cross_sum()", "[batch]",
+                   int, long, double, float)
+{
+    using T = TestType;
+    const auto [lhs, rhs] = generate_points<T, 2>();
+    vector3<double> expected = { 0, 0, 0 };
+    double magnitude = 0;
+    for (std::size_t i = 0; i != count; ++i) {
+        const vector3<T> c = cross(lhs[i], rhs[i]);
+        expected += vector3<double>{ (double)c.x, (double)c.y, (double)c.z };
+        magnitude += 2 * std::max({ std::abs(lhs[i].x), std::abs(lhs[i].y), std::abs(lhs[i].z) })
+                       * std::max({ std::abs(rhs[i].x), std::abs(rhs[i].y), std::abs(rhs[i].z) });
+    }
+    const vector3<T> actual = batch::cross_sum(lhs.span(), rhs.span());
+    if constexpr (std::integral<T>) {
+        CHECK(actual.x == expected.x);
+        CHECK(actual.y == expected.y);
+        CHECK(actual.z == expected.z);
+    } else {
+        CHECK_THAT(actual.x, WithinAbs(expected.x, magnitude * std::numeric_limits<T>::epsilon()));
+        CHECK_THAT(actual.y, WithinAbs(expected.y, magnitude * std::numeric_limits<T>::epsilon()));
+        CHECK_THAT(actual.z, WithinAbs(expected.z, magnitude * std::numeric_limits<T>::epsilon()));
+    }
+}
+
+TEMPLATE_TEST_CASE("constexpr", "[batch]",
+                   int, long, double, float)
+{
+    using T = TestType;
+    constexpr auto transformed = [] {
+        std::array<T, 3> x = { 1, 2, 3 };
+        std::array<T, 3> y = { 4, 5, 6 };
+        std::array<T, 3> z = { 7, 8, 9 };
+        const span3<T> p = { x, y, z };
+        return batch::transform_bounds(p, p, matrix3<T>{ 0, 1, 0, 0, 0, 1, 1, 0, 0 });
+    }();
+    STATIC_CHECK(transformed.min == point3<T>{ 4, 7, 1 });
+    STATIC_CHECK(transformed.max == point3<T>{ 6, 9, 3 });
+
+    constexpr auto sums = [] {
+        // (1, 0, 0) and (0, 1, 0), then (0, 1, 0) and (0, 0, 1)
+        const std::array<T, 2> zero_one = { 0, 1 };
+        const std::array<T, 2> one_zero = { 1, 0 };
+        const std::array<T, 2> zero_zero = { 0, 0 };
+        const span3<const T> lhs = { one_zero, zero_one, zero_zero };
+        const span3<const T> rhs = { zero_zero, one_zero, zero_one };
+        return std::pair{ batch::dot_sum(lhs, lhs), batch::cross_sum(lhs, rhs) };
+    }();
+    STATIC_CHECK(sums.first == 2);
+    STATIC_CHECK(sums.second == vector3<T>{ 1, 0, 1 });
+}
+
+} // namespace
+} // namespace pstack::geo
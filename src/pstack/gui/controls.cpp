@@ -84,7 +84,7 @@ void controls::initialize(main_window* parent) {
             "It may not be possible to remove a part from inside another part without a big enough hole.\n\n"
             "The application starts with a solid cube the size of your part and then uses a cube the"
             "size of the minimum hole to *carve* away from the other cube until it cannot go any further.\n\n"
-            "(Not yet implemented) Click the \"Preview voxelization\" button to see how changing minimum hole affects the voxelization.";
+            "Click the \"Preview voxelization\" button to see how changing minimum hole affects the voxelization.";
         const wxString minimize_tooltip =
             "This setting chooses whether the parts are first rotated to a more optimal orientation before performing any other steps. "
             "The application will attempt to minimizes their axis-aligned bounding boxes.\n\n"
@@ -94,7 +94,9 @@ void controls::initialize(main_window* parent) {
             "None = The parts will always be oriented exactly as they are imported.\n\n"
             "Cubic = The parts will be rotated by some multiple of 90 degrees from their starting orientations.\n\n"
             "Arbitrary = The parts will be oriented in one of 32 random possible rotations. The rotations are constant for the duration of the application, and will be re-randomized next time the application is launched.";
-        const wxString preview_voxelization_tooltip = "*NOT YET IMPLEMENTED*\nShows a preview of the voxelization. Used to check if there are any open holes into the internal volume of the part.";
+        const wxString preview_voxelization_tooltip =
+            "Shows a preview of the voxelization of the selected part, at the current resolution. Used to check if there are any open holes into the internal volume of the part.\n\n"
+            "While the preview is shown, changing the minimum hole updates it.";
 
         quantity_text->SetToolTip(quantity_tooltip);
         min_hole_text->SetToolTip(min_hole_tooltip);
@@ -132,6 +134,11 @@ void controls::initialize(main_window* parent) {
         min_clearance_spinner->SetDigits(2);
         min_clearance_spinner->SetIncrement(0.05);
         min_clearance_spinner->SetRange(0.5, 2);
+        exact_clearance_text = new wxStaticText(panel, wxID_ANY, "Exact clearance:");
+        exact_clearance_spinner = new wxSpinCtrlDouble(panel);
+        exact_clearance_spinner->SetDigits(2);
+        exact_clearance_spinner->SetIncrement(0.05);
+        exact_clearance_spinner->SetRange(0, 5);
 
         constexpr auto make_tooltip = [](const char* state, char dir) {
             return wxString::Format("%s size of the bounding box %c direction", state, dir);
@@ -154,6 +161,71 @@ void controls::initialize(main_window* parent) {
             "Also the voxel size fed into the stacking algorithm.";
         min_clearance_text->SetToolTip(min_clearance_tooltip);
         min_clearance_spinner->SetToolTip(min_clearance_tooltip);
+
+        const wxString exact_clearance_tooltip =
+            "The distance kept between stacked parts, measured exactly rather than in whole voxels. "
+            "This allows a larger voxel size to stack faster, while still keeping a precise gap between parts. "
+            "When 0, parts are kept one voxel apart.";
+        exact_clearance_text->SetToolTip(exact_clearance_tooltip);
+        exact_clearance_spinner->SetToolTip(exact_clearance_tooltip);
+
+        multiple_plates_text = new wxStaticText(panel, wxID_ANY, "Multiple plates:");
+        multiple_plates_checkbox = new wxCheckBox(panel, wxID_ANY, "");
+        const wxString multiple_plates_tooltip =
+            "Parts which do not fit within the maximum bounding box are stacked onto additional plates, instead of failing. "
+            "Each plate becomes a separate result.";
+        multiple_plates_text->SetToolTip(multiple_plates_tooltip);
+        multiple_plates_checkbox->SetToolTip(multiple_plates_tooltip);
+
+        wxArrayString placement_choices;
+        placement_choices.Add("Full scan");
+        placement_choices.Add("Extreme points");
+        placement_choices.Add("Drop");
+        placement_text = new wxStaticText(panel, wxID_ANY, "Placement:");
+        placement_dropdown = new wxChoice(panel, wxID_ANY, wxDefaultPosition, wxDefaultSize, placement_choices);
+        const wxString placement_tooltip =
+            "How positions are searched for each part. "
+            "Full scan tries every position in the bounding box. "
+            "Extreme points only tries the corners of parts already placed, which is faster but may pack less tightly. "
+            "Drop lowers parts straight down onto the parts already placed, which is fastest for tall builds.";
+        placement_text->SetToolTip(placement_tooltip);
+        placement_dropdown->SetToolTip(placement_tooltip);
+
+        wxArrayString fill_choices;
+        fill_choices.Add("Convex");
+        fill_choices.Add("Ray parity");
+        fill_text = new wxStaticText(panel, wxID_ANY, "Interior fill:");
+        fill_dropdown = new wxChoice(panel, wxID_ANY, wxDefaultPosition, wxDefaultSize, fill_choices);
+        const wxString fill_tooltip =
+            "How the inside of parts with a minimum hole size is filled in. "
+            "Convex fills every line through the part between its outermost surfaces, except where a hole of the minimum size reaches in from outside, so sealed cavities are filled. "
+            "Ray parity fills the same, and also whatever rays through the part find enclosed by its surface, so that holes in a broken mesh do not leave it hollowed out.";
+        fill_text->SetToolTip(fill_tooltip);
+        fill_dropdown->SetToolTip(fill_tooltip);
+
+        resample_rotations_text = new wxStaticText(panel, wxID_ANY, "Resample rotations:");
+        resample_rotations_checkbox = new wxCheckBox(panel, wxID_ANY, "");
+        const wxString resample_rotations_tooltip =
+            "Parts with arbitrary rotations are voxelized once at twice the resolution, and each rotation is derived from that, instead of voxelizing every rotation. "
+            "This is much faster for detailed parts, but leaves slightly more space around each part.";
+        resample_rotations_text->SetToolTip(resample_rotations_tooltip);
+        resample_rotations_checkbox->SetToolTip(resample_rotations_tooltip);
+
+        batch_growth_text = new wxStaticText(panel, wxID_ANY, "Batch growth:");
+        batch_growth_checkbox = new wxCheckBox(panel, wxID_ANY, "");
+        const wxString batch_growth_tooltip =
+            "When the bounding box has to grow, several larger sizes are tried at once on spare threads, jumping straight to one which fits every remaining instance of the part. "
+            "This is faster for large quantities, but can give a different, sometimes looser, result than growing one instance at a time.";
+        batch_growth_text->SetToolTip(batch_growth_tooltip);
+        batch_growth_checkbox->SetToolTip(batch_growth_tooltip);
+
+        tile_lattices_text = new wxStaticText(panel, wxID_ANY, "Lattice tiling:");
+        tile_lattices_checkbox = new wxCheckBox(panel, wxID_ANY, "");
+        const wxString tile_lattices_tooltip =
+            "Parts with a quantity of at least 16 are first stamped out along the lattice which packs them most tightly, before the rest are placed one at a time. "
+            "This can be much faster for large quantities of one part, but the layers fill the initial width and depth before growing upwards, which can make the result taller.";
+        tile_lattices_text->SetToolTip(tile_lattices_tooltip);
+        tile_lattices_checkbox->SetToolTip(tile_lattices_tooltip);
     }
 
     {
@@ -215,12 +287,19 @@ void controls::reset_values() {
 
     calc::stack_settings stack{}; // Get the defaults
     min_clearance_spinner->SetValue(stack.resolution);
+    exact_clearance_spinner->SetValue(stack.clearance);
     initial_x_spinner->SetValue(stack.x_min);
     initial_y_spinner->SetValue(stack.y_min);
     initial_z_spinner->SetValue(stack.z_min);
     maximum_x_spinner->SetValue(stack.x_max);
     maximum_y_spinner->SetValue(stack.y_max);
     maximum_z_spinner->SetValue(stack.z_max);
+    multiple_plates_checkbox->SetValue(stack.multiple_plates);
+    placement_dropdown->SetSelection(static_cast<int>(stack.placement));
+    fill_dropdown->SetSelection(static_cast<int>(stack.fill));
+    resample_rotations_checkbox->SetValue(stack.resample_rotations);
+    batch_growth_checkbox->SetValue(stack.batch_growth);
+    tile_lattices_checkbox->SetValue(stack.tile_lattices);
 }
 
 } // namespace pstack::gui
@@ -67,6 +67,20 @@ struct controls {
     wxSpinCtrl* maximum_z_spinner;
     wxStaticText* min_clearance_text;
     wxSpinCtrlDouble* min_clearance_spinner;
+    wxStaticText* exact_clearance_text;
+    wxSpinCtrlDouble* exact_clearance_spinner;
+    wxStaticText* multiple_plates_text;
+    wxCheckBox* multiple_plates_checkbox;
+    wxStaticText* placement_text;
+    wxChoice* placement_dropdown;
+    wxStaticText* fill_text;
+    wxChoice* fill_dropdown;
+    wxStaticText* resample_rotations_text;
+    wxCheckBox* resample_rotations_checkbox;
+    wxStaticText* batch_growth_text;
+    wxCheckBox* batch_growth_checkbox;
+    wxStaticText* tile_lattices_text;
+    wxCheckBox* tile_lattices_checkbox;
 
     // Sinterbox tab
     wxStaticText* clearance_text;
@@ -18,6 +18,13 @@
 
 namespace pstack::gui {
 
+namespace {
+
+// Mirrors along x, as the mirror button does
+constexpr geo::matrix3<float> mirror_x = { -1, 0, 0, 0, 1, 0, 0, 0, 1 };
+
+} // namespace
+
 main_window::main_window(const wxString& title)
     : wxFrame(nullptr, wxID_ANY, title, wxDefaultPosition, wxDefaultSize)
 {
@@ -54,6 +61,13 @@ calc::stack_settings main_window::stack_settings() const {
         .x_min = _controls.initial_x_spinner->GetValue(), .x_max = _controls.maximum_x_spinner->GetValue(),
         .y_min = _controls.initial_y_spinner->GetValue(), .y_max = _controls.maximum_y_spinner->GetValue(),
         .z_min = _controls.initial_z_spinner->GetValue(), .z_max = _controls.maximum_z_spinner->GetValue(),
+        .multiple_plates = _controls.multiple_plates_checkbox->GetValue(),
+        .placement = static_cast<calc::placement_mode>(_controls.placement_dropdown->GetSelection()),
+        .fill = static_cast<calc::fill_mode>(_controls.fill_dropdown->GetSelection()),
+        .resample_rotations = _controls.resample_rotations_checkbox->GetValue(),
+        .clearance = _controls.exact_clearance_spinner->GetValue(),
+        .batch_growth = _controls.batch_growth_checkbox->GetValue(),
+        .tile_lattices = _controls.tile_lattices_checkbox->GetValue(),
     };
 }
 
@@ -65,6 +79,13 @@ void main_window::stack_settings(const calc::stack_settings& settings) {
     _controls.maximum_y_spinner->SetValue(settings.y_max);
     _controls.initial_z_spinner->SetValue(settings.z_min);
     _controls.maximum_z_spinner->SetValue(settings.z_max);
+    _controls.multiple_plates_checkbox->SetValue(settings.multiple_plates);
+    _controls.placement_dropdown->SetSelection(static_cast<int>(settings.placement));
+    _controls.fill_dropdown->SetSelection(static_cast<int>(settings.fill));
+    _controls.resample_rotations_checkbox->SetValue(settings.resample_rotations);
+    _controls.exact_clearance_spinner->SetValue(settings.clearance);
+    _controls.batch_growth_checkbox->SetValue(settings.batch_growth);
+    _controls.tile_lattices_checkbox->SetValue(settings.tile_lattices);
 }
 
 calc::sinterbox_settings main_window::sinterbox_settings() const {
@@ -84,6 +105,7 @@ void main_window::sinterbox_settings(const calc::sinterbox_settings& settings) {
 }
 
 void main_window::on_select_parts(const std::vector<std::size_t>& indices) {
+    reset_voxel_preview();
     const bool any_selected = not indices.empty();
     _controls.delete_part_button->Enable(any_selected);
     _controls.reload_part_button->Enable(any_selected);
@@ -161,6 +183,57 @@ void main_window::enable_part_settings(bool enable) {
     _controls.preview_voxelization_button->Enable(enable);
 }
 
+void main_window::start_voxel_preview() {
+    const calc::part& part = *_current_parts[0].part;
+    const calc::stack_settings settings = stack_settings();
+    _voxel_preview_shown = true;
+    _preview_thread.start(part.mesh, settings.resolution, settings.fill, settings.clearance, part.min_hole, on_voxel_preview());
+}
+
+void main_window::refill_voxel_preview() {
+    _preview_thread.refill(_current_parts[0].part->min_hole, on_voxel_preview());
+}
+
+void main_window::reset_voxel_preview() {
+    _voxel_preview_shown = false;
+    ++_voxel_preview_count;
+}
+
+std::function<void(calc::mesh)> main_window::on_voxel_preview() {
+    const std::size_t count = ++_voxel_preview_count;
+    const geo::point3<float> centroid = _current_parts[0].part->centroid;
+    return [this, count, centroid](calc::mesh mesh) {
+        CallAfter([=, mesh = std::move(mesh)] {
+            if (count == _voxel_preview_count) {
+                _viewport->set_mesh(mesh, centroid);
+            }
+        });
+    };
+}
+
+void main_window::start_min_box(const std::size_t index) {
+    const std::weak_ptr<calc::part> weak = _parts_list.weak_at(index);
+    const calc::part& part = _parts_list.at(index);
+    const bool mirrored = part.mirrored;
+    _min_box_thread.start(part.mesh, [this, weak, mirrored](const geo::matrix3<float> rotation) {
+        CallAfter([=] {
+            const auto set = [=] {
+                // Dropped if the part was deleted since, or reloaded from its file, which also clears `rotate_min_box`
+                const std::shared_ptr<calc::part> part = weak.lock();
+                if (part == nullptr or not part->rotate_min_box) {
+                    return;
+                }
+                part->min_box_rotation = part->mirrored == mirrored ? rotation : mirror_x * rotation * mirror_x;
+            };
+            if (_controls.stack_button->GetLabelText() == "Stop") {
+                _after_stacking.push_back(set);
+            } else {
+                set();
+            }
+        });
+    });
+}
+
 void main_window::on_select_results(const std::vector<std::size_t>& indices) {
     const auto size = indices.size();
     _controls.export_result_button->Enable(size == 1);
@@ -174,6 +247,7 @@ void main_window::on_select_results(const std::vector<std::size_t>& indices) {
 }
 
 void main_window::set_result(const std::size_t index) {
+    reset_voxel_preview();
     _current_result = &_results_list.at(index);
     const auto& result = _results_list.at(index);
     const auto bounding = result.mesh.bounding();
@@ -239,9 +313,9 @@ void main_window::on_stacking_start() {
                 _viewport->set_mesh(mesh, { max.x / 2.0f, max.y / 2.0f, max.z / 2.0f });
             });
         },
-        .on_success = [this](calc::stack_result result, const std::chrono::system_clock::duration elapsed) {
-            CallAfter([=, result = std::move(result)] {
-                on_stacking_success(std::move(result), elapsed);
+        .on_success = [this](std::vector<calc::stack_result> results, const std::chrono::system_clock::duration elapsed) {
+            CallAfter([=, results = std::move(results)] {
+                on_stacking_success(std::move(results), elapsed);
             });
         },
         .on_failure = [this] {
@@ -256,6 +330,7 @@ void main_window::on_stacking_start() {
             });
         },
     };
+    reset_voxel_preview();
     enable_on_stacking(true);
     _stacker_thread.start(std::move(params));
 }
@@ -266,14 +341,28 @@ void main_window::on_stacking_stop() {
     }
 }
 
-void main_window::on_stacking_success(calc::stack_result result, const std::chrono::system_clock::duration elapsed) {
-    _results_list.append(std::move(result));
-    set_result(_results_list.rows() - 1);
-
-    const auto message = wxString::Format(
-        "Stacking complete!\n\nElapsed time: %.1fs\n\nFinal bounding box: %.1fx%.1fx%.1fmm (%.1f%% density).",
-        std::chrono::duration_cast<std::chrono::duration<double>>(elapsed).count(),
-        _current_result->size.x, _current_result->size.y, _current_result->size.z, 100 * _current_result->density);
+void main_window::on_stacking_success(std::vector<calc::stack_result> results, const std::chrono::system_clock::duration elapsed) {
+    const std::size_t plates = results.size();
+    for (auto& result : results) {
+        _results_list.append(std::move(result));
+    }
+    const std::size_t first_row = _results_list.rows() - plates;
+
+    auto message = wxString::Format("Stacking complete!\n\nElapsed time: %.1fs\n\n",
+        std::chrono::duration_cast<std::chrono::duration<double>>(elapsed).count());
+    if (plates == 1) {
+        const auto& result = _results_list.at(first_row);
+        message += wxString::Format("Final bounding box: %.1fx%.1fx%.1fmm (%.1f%% density).",
+            result.size.x, result.size.y, result.size.z, 100 * result.density);
+    } else {
+        message += wxString::Format("Stacked onto %zu plates:", plates);
+        for (std::size_t i = 0; i != plates; ++i) {
+            const auto& result = _results_list.at(first_row + i);
+            message += wxString::Format("\n    Plate %zu: %.1fx%.1fx%.1fmm (%.1f%% density).",
+                i + 1, result.size.x, result.size.y, result.size.z, 100 * result.density);
+        }
+    }
+    set_result(first_row);
     wxMessageBox(message, "Stacking complete");
 }
 
@@ -321,9 +410,23 @@ void main_window::enable_on_stacking(const bool starting) {
     _controls.maximum_z_spinner->Enable(enable);
 
     _controls.min_clearance_spinner->Enable(enable);
+    _controls.exact_clearance_spinner->Enable(enable);
+    _controls.multiple_plates_checkbox->Enable(enable);
+    _controls.placement_dropdown->Enable(enable);
+    _controls.fill_dropdown->Enable(enable);
+    _controls.resample_rotations_checkbox->Enable(enable);
+    _controls.batch_growth_checkbox->Enable(enable);
+    _controls.tile_lattices_checkbox->Enable(enable);
     _controls.section_view_checkbox->Enable(enable);
     _controls.stack_button->SetLabelText(enable ? "Stack" : "Stop");
     _controls.progress_bar->SetValue(0);
+
+    if (enable) {
+        for (const std::function<void()>& change : _after_stacking) {
+            change();
+        }
+        _after_stacking.clear();
+    }
 }
 
 wxMenuBar* main_window::make_menu_bar() {
@@ -500,6 +603,10 @@ void main_window::bind_all_controls() {
             current_part.part->mirrored = not current_part.part->mirrored;
             current_part.part->mesh.mirror_x();
             current_part.part->mesh.set_baseline({ 0, 0, 0 });
+            // The mirrored mesh has the mirror image of the same smallest box
+            if (current_part.part->min_box_rotation.has_value()) {
+                current_part.part->min_box_rotation = mirror_x * *current_part.part->min_box_rotation * mirror_x;
+            }
             _parts_list.reload_text(current_part.index);
         }
         on_select_parts(indices);
@@ -526,11 +633,17 @@ void main_window::bind_all_controls() {
         for (auto& current_part : _current_parts) {
             current_part.part->min_hole = event.GetPosition();
         }
+        if (_voxel_preview_shown) {
+            refill_voxel_preview();
+        }
         event.Skip();
     });
     _controls.minimize_checkbox->Bind(wxEVT_CHECKBOX, [this](wxCommandEvent& event) {
         for (auto& current_part : _current_parts) {
             current_part.part->rotate_min_box = event.IsChecked();
+            if (event.IsChecked() and not current_part.part->min_box_rotation.has_value()) {
+                start_min_box(current_part.index);
+            }
         }
         event.Skip();
     });
@@ -543,7 +656,32 @@ void main_window::bind_all_controls() {
     });
 
     _controls.preview_voxelization_button->Bind(wxEVT_BUTTON, [this](wxCommandEvent& event) {
-        wxMessageBox("Not yet implemented", "Error", wxICON_WARNING);
+        if (_current_parts.size() != 1) {
+            wxMessageBox("Select a single part to preview", "Error", wxICON_WARNING);
+            return;
+        }
+        start_voxel_preview();
+        event.Skip();
+    });
+
+    // The preview voxelizes with the stack settings, so it is redone when they change
+    _controls.min_clearance_spinner->Bind(wxEVT_SPINCTRLDOUBLE, [this](wxSpinDoubleEvent& event) {
+        if (_voxel_preview_shown) {
+            start_voxel_preview();
+        }
+        event.Skip();
+    });
+    _controls.exact_clearance_spinner->Bind(wxEVT_SPINCTRLDOUBLE, [this](wxSpinDoubleEvent& event) {
+        if (_voxel_preview_shown) {
+            start_voxel_preview();
+        }
+        event.Skip();
+    });
+    _controls.fill_dropdown->Bind(wxEVT_CHOICE, [this](wxCommandEvent& event) {
+        if (_voxel_preview_shown) {
+            start_voxel_preview();
+        }
+        event.Skip();
     });
 
     _controls.section_view_checkbox->Bind(wxEVT_CHECKBOX, [this](wxCommandEvent& event) {
@@ -579,6 +717,8 @@ void main_window::on_close(wxCloseEvent& event) {
         }
     }
     _stacker_thread.stop();
+    _preview_thread.stop();
+    _min_box_thread.stop();
     event.Skip();
 }
 
@@ -887,9 +1027,58 @@ void main_window::arrange_tab_stack_settings(wxPanel* panel) {
     min_clearance_sizer->AddSpacer(4 * FromDIP(constants::inner_border));
     min_clearance_sizer->Add(_controls.min_clearance_spinner, 0, wxALIGN_CENTER_VERTICAL);
 
+    auto exact_clearance_sizer = new wxBoxSizer(wxHORIZONTAL);
+    exact_clearance_sizer->Add(_controls.exact_clearance_text, 0, wxALIGN_CENTER_VERTICAL);
+    exact_clearance_sizer->AddSpacer(4 * FromDIP(constants::inner_border));
+    exact_clearance_sizer->Add(_controls.exact_clearance_spinner, 0, wxALIGN_CENTER_VERTICAL);
+
+    auto multiple_plates_sizer = new wxBoxSizer(wxHORIZONTAL);
+    multiple_plates_sizer->Add(_controls.multiple_plates_text, 0, wxALIGN_CENTER_VERTICAL);
+    multiple_plates_sizer->AddSpacer(4 * FromDIP(constants::inner_border));
+    multiple_plates_sizer->Add(_controls.multiple_plates_checkbox, 0, wxALIGN_CENTER_VERTICAL);
+
+    auto placement_sizer = new wxBoxSizer(wxHORIZONTAL);
+    placement_sizer->Add(_controls.placement_text, 0, wxALIGN_CENTER_VERTICAL);
+    placement_sizer->AddSpacer(4 * FromDIP(constants::inner_border));
+    placement_sizer->Add(_controls.placement_dropdown, 0, wxALIGN_CENTER_VERTICAL);
+
+    auto fill_sizer = new wxBoxSizer(wxHORIZONTAL);
+    fill_sizer->Add(_controls.fill_text, 0, wxALIGN_CENTER_VERTICAL);
+    fill_sizer->AddSpacer(4 * FromDIP(constants::inner_border));
+    fill_sizer->Add(_controls.fill_dropdown, 0, wxALIGN_CENTER_VERTICAL);
+
+    auto resample_rotations_sizer = new wxBoxSizer(wxHORIZONTAL);
+    resample_rotations_sizer->Add(_controls.resample_rotations_text, 0, wxALIGN_CENTER_VERTICAL);
+    resample_rotations_sizer->AddSpacer(4 * FromDIP(constants::inner_border));
+    resample_rotations_sizer->Add(_controls.resample_rotations_checkbox, 0, wxALIGN_CENTER_VERTICAL);
+
+    auto batch_growth_sizer = new wxBoxSizer(wxHORIZONTAL);
+    batch_growth_sizer->Add(_controls.batch_growth_text, 0, wxALIGN_CENTER_VERTICAL);
+    batch_growth_sizer->AddSpacer(4 * FromDIP(constants::inner_border));
+    batch_growth_sizer->Add(_controls.batch_growth_checkbox, 0, wxALIGN_CENTER_VERTICAL);
+
+    auto tile_lattices_sizer = new wxBoxSizer(wxHORIZONTAL);
+    tile_lattices_sizer->Add(_controls.tile_lattices_text, 0, wxALIGN_CENTER_VERTICAL);
+    tile_lattices_sizer->AddSpacer(4 * FromDIP(constants::inner_border));
+    tile_lattices_sizer->Add(_controls.tile_lattices_checkbox, 0, wxALIGN_CENTER_VERTICAL);
+
     sizer->Add(bounding_box_sizer_, 0, wxEXPAND | wxLEFT | wxRIGHT);
     sizer->AddSpacer(FromDIP(constants::inner_border));
     sizer->Add(min_clearance_sizer);
+    sizer->AddSpacer(FromDIP(constants::inner_border));
+    sizer->Add(exact_clearance_sizer);
+    sizer->AddSpacer(FromDIP(constants::inner_border));
+    sizer->Add(multiple_plates_sizer);
+    sizer->AddSpacer(FromDIP(constants::inner_border));
+    sizer->Add(placement_sizer);
+    sizer->AddSpacer(FromDIP(constants::inner_border));
+    sizer->Add(fill_sizer);
+    sizer->AddSpacer(FromDIP(constants::inner_border));
+    sizer->Add(resample_rotations_sizer);
+    sizer->AddSpacer(FromDIP(constants::inner_border));
+    sizer->Add(batch_growth_sizer);
+    sizer->AddSpacer(FromDIP(constants::inner_border));
+    sizer->Add(tile_lattices_sizer);
 }
 
 void main_window::arrange_tab_results(wxPanel* panel) {
@@ -7,9 +7,13 @@
 #include <wx/sizer.h>
 #include <wx/spinctrl.h>
 #include <wx/string.h>
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <vector>
+#include "pstack/calc/min_box_thread.hpp"
+#include "pstack/calc/preview_thread.hpp"
 #include "pstack/calc/stacker_thread.hpp"
 #include "pstack/calc/stacker.hpp"
 #include "pstack/gui/controls.hpp"
@@ -42,6 +46,16 @@ private:
     };
     std::vector<_current_part_t> _current_parts{};
     void enable_part_settings(bool enable);
+    calc::preview_thread _preview_thread;
+    bool _voxel_preview_shown = false; // Of the one selected part
+    std::size_t _voxel_preview_count = 0; // Of previews asked for, so that one finishing after the part or settings changed is not shown
+    void start_voxel_preview();
+    void refill_voxel_preview();
+    void reset_voxel_preview();
+    std::function<void(calc::mesh)> on_voxel_preview();
+    calc::min_box_thread _min_box_thread;
+    std::vector<std::function<void()>> _after_stacking{}; // Changes to the parts which wait until the stacker stops reading them
+    void start_min_box(std::size_t index);
 
     void on_select_results(const std::vector<std::size_t>& indices);
     void set_result(std::size_t index);
@@ -54,7 +68,7 @@ private:
     void on_stacking(wxCommandEvent& event);
     void on_stacking_start();
     void on_stacking_stop();
-    void on_stacking_success(calc::stack_result result, std::chrono::system_clock::duration elapsed);
+    void on_stacking_success(std::vector<calc::stack_result> results, std::chrono::system_clock::duration elapsed);
     void enable_on_stacking(bool starting);
     calc::stacker_thread _stacker_thread;
 
@@ -31,6 +31,9 @@ public:
     calc::part& at(std::size_t row) {
         return *_parts.at(row);
     }
+    std::weak_ptr<calc::part> weak_at(std::size_t row) const {
+        return _parts.at(row);
+    }
     std::vector<std::shared_ptr<const calc::part>> get_all() const;
     void replace_all(std::vector<std::shared_ptr<calc::part>>&& parts);
 
@@ -22,7 +22,7 @@ void results_list::append(calc::stack_result input) {
         std::to_string(result.pieces.size()),
         wxString::Format("%.1f%%", 100 * result.density),
         wxString::Format("%.1fx%.1fx%.1f", result.size.x, result.size.y, result.size.z),
-        std::to_string(result.mesh.triangles().size()),
+        std::to_string(result.mesh.triangle_count()),
         (not result.sinterbox.has_value()) ? wxString("none")
             : wxString::Format("%.1f,%.1f,%.1f,%.1f", result.sinterbox->settings.clearance, result.sinterbox->settings.spacing, result.sinterbox->settings.thickness, result.sinterbox->settings.width),
     });
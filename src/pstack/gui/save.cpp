@@ -28,8 +28,14 @@ using internal_save_state = basic_save_state<save_part, save_result>;
 JSONCONS_N_MEMBER_TRAITS(pstack::gui::preferences, 0, // Nothing is required
     invert_scroll, extra_parts, show_bounding_box, load_environment_popup
 );
+JSONCONS_ENUM_TRAITS(pstack::calc::placement_mode,
+    scan, extreme_points, drop
+);
+JSONCONS_ENUM_TRAITS(pstack::calc::fill_mode,
+    convex, parity
+);
 JSONCONS_N_MEMBER_TRAITS(pstack::calc::stack_settings, 0, // Nothing is required
-    resolution, x_min, x_max, y_min, y_max, z_min, z_max
+    resolution, x_min, x_max, y_min, y_max, z_min, z_max, multiple_plates, placement, fill, resample_rotations, clearance, batch_growth, tile_lattices
 );
 JSONCONS_N_MEMBER_TRAITS(pstack::calc::sinterbox_settings, 0, // Nothing is required
     clearance, thickness, width, spacing
@@ -117,7 +123,14 @@ const std::string_view the_schema = R"the_schema({
                 "y_min": { "$ref": "#/$defs/unsigned_int" },
                 "y_max": { "$ref": "#/$defs/unsigned_int" },
                 "z_min": { "$ref": "#/$defs/unsigned_int" },
-                "z_max": { "$ref": "#/$defs/unsigned_int" }
+                "z_max": { "$ref": "#/$defs/unsigned_int" },
+                "multiple_plates": { "type": "boolean" },
+                "placement": { "enum": ["scan", "extreme_points", "drop"] },
+                "fill": { "enum": ["convex", "parity"] },
+                "resample_rotations": { "type": "boolean" },
+                "clearance": { "type": "number" },
+                "batch_growth": { "type": "boolean" },
+                "tile_lattices": { "type": "boolean" }
             }
         },
         "sinterbox": {
@@ -141,7 +141,8 @@ void viewport::set_mesh_vao(const calc::mesh& mesh) {
     _mesh_vao.clear();
     std::vector<geo::vector3<float>> vertices;
     std::vector<geo::vector3<float>> normals;
-    for (const auto& t : mesh.triangles()) {
+    for (std::size_t i = 0; i != mesh.triangle_count(); ++i) {
+        const geo::triangle t = mesh.triangle(i);
         vertices.push_back(t.v1.as_vector());
         vertices.push_back(t.v2.as_vector());
         vertices.push_back(t.v3.as_vector());
@@ -0,0 +1,136 @@
+#ifndef PSTACK_UTIL_BRICK_GRID_HPP
+#define PSTACK_UTIL_BRICK_GRID_HPP
+
+#include "pstack/util/mdarray.hpp"
+#include "pstack/util/parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <memory>
+#include <vector>
+
+namespace pstack::util {
+
+// A sparse three-dimensional array, split into bricks of `brick_size` elements along each axis.
+// Only bricks with differing elements are stored in full. A brick whose elements are all the same,
+// such as one which is entirely empty or entirely full, is stored as just that one value.
+template <class T>
+class brick_grid {
+public:
+    static constexpr std::size_t brick_size = 8;
+    static constexpr std::size_t brick_volume = brick_size * brick_size * brick_size;
+
+    using extents_type = typename mdspan<T, 3>::extents_type;
+
+    constexpr brick_grid() = default;
+
+    template <std::convertible_to<std::size_t> X, std::convertible_to<std::size_t> Y, std::convertible_to<std::size_t> Z>
+    constexpr brick_grid(const X x, const Y y, const Z z)
+        : _extents{ static_cast<std::size_t>(x), static_cast<std::size_t>(y), static_cast<std::size_t>(z) }
+        , _bricks{ bricks_for(_extents[0]), bricks_for(_extents[1]), bricks_for(_extents[2]) }
+        , _uniform(_bricks[0] * _bricks[1] * _bricks[2], T{})
+        , _stored(_uniform.size())
+    {}
+
+    brick_grid(const brick_grid& that)
+        : _extents(that._extents)
+        , _bricks(that._bricks)
+        , _uniform(that._uniform)
+        , _stored(that._stored.size())
+    {
+        for (std::size_t b = 0; b != _stored.size(); ++b) {
+            if (that._stored[b] != nullptr) {
+                _stored[b] = std::make_unique_for_overwrite<T[]>(brick_volume);
+                std::copy_n(that._stored[b].get(), brick_volume, _stored[b].get());
+            }
+        }
+    }
+
+    brick_grid(brick_grid&&) = default;
+
+    brick_grid& operator=(const brick_grid& that) {
+        return *this = brick_grid(that);
+    }
+
+    brick_grid& operator=(brick_grid&&) = default;
+
+    constexpr std::size_t extent(const std::size_t axis) const {
+        return _extents[axis];
+    }
+
+    constexpr extents_type extents() const {
+        return extents_type(_extents[0], _extents[1], _extents[2]);
+    }
+
+    // The number of bricks along `axis`
+    constexpr std::size_t bricks(const std::size_t axis) const {
+        return _bricks[axis];
+    }
+
+    // The elements of the brick, indexed like a `brick_size` cube in row-major order, or `nullptr` if the brick is uniform
+    const T* brick(const std::size_t bx, const std::size_t by, const std::size_t bz) const {
+        return _stored[brick_index(bx, by, bz)].get();
+    }
+
+    // The value of every element of a uniform brick
+    constexpr const T& uniform(const std::size_t bx, const std::size_t by, const std::size_t bz) const {
+        return _uniform[brick_index(bx, by, bz)];
+    }
+
+    const T& at(const std::size_t x, const std::size_t y, const std::size_t z) const {
+        const std::size_t b = brick_index(x / brick_size, y / brick_size, z / brick_size);
+        return _stored[b] == nullptr ? _uniform[b] : _stored[b][element_index(x, y, z)];
+    }
+
+    // A reference to one element, for which its brick is stored in full first.
+    // Threads may call this at the same time as long as they never touch the same brick.
+    T& element(const std::size_t x, const std::size_t y, const std::size_t z) {
+        const std::size_t b = brick_index(x / brick_size, y / brick_size, z / brick_size);
+        if (_stored[b] == nullptr) {
+            _stored[b] = std::make_unique_for_overwrite<T[]>(brick_volume);
+            std::fill_n(_stored[b].get(), brick_volume, _uniform[b]);
+        }
+        return _stored[b][element_index(x, y, z)];
+    }
+
+    // Goes back to storing any brick whose elements have all become the same as a single value
+    void compact() {
+        parallel_for(_bricks[0], [&](const std::size_t bx) {
+            compact(bx);
+        });
+    }
+
+    // As above, for the bricks in the slab `bx` along x only, so that a slab can be compacted as soon as it has been written.
+    // Threads may call this at the same time as long as they never touch the same slab.
+    void compact(const std::size_t bx) {
+        for (std::size_t b = brick_index(bx, 0, 0); b != brick_index(bx + 1, 0, 0); ++b) {
+            const T* const stored = _stored[b].get();
+            if (stored != nullptr and std::all_of(stored, stored + brick_volume, [&](const T& value) { return value == stored[0]; })) {
+                _uniform[b] = stored[0];
+                _stored[b].reset();
+            }
+        }
+    }
+
+private:
+    std::array<std::size_t, 3> _extents{};
+    std::array<std::size_t, 3> _bricks{};
+    std::vector<T> _uniform{};
+    std::vector<std::unique_ptr<T[]>> _stored{}; // Empty for uniform bricks
+
+    static constexpr std::size_t bricks_for(const std::size_t extent) {
+        return (extent + brick_size - 1) / brick_size;
+    }
+
+    constexpr std::size_t brick_index(const std::size_t bx, const std::size_t by, const std::size_t bz) const {
+        return (bx * _bricks[1] + by) * _bricks[2] + bz;
+    }
+
+    static constexpr std::size_t element_index(const std::size_t x, const std::size_t y, const std::size_t z) {
+        return ((x % brick_size) * brick_size + y % brick_size) * brick_size + z % brick_size;
+    }
+};
+
+} // namespace pstack::util
+
+#endif // PSTACK_UTIL_BRICK_GRID_HPP
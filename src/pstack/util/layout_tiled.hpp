@@ -0,0 +1,85 @@
+#ifndef PSTACK_UTIL_LAYOUT_TILED_HPP
+#define PSTACK_UTIL_LAYOUT_TILED_HPP
+
+#include <array>
+#include <cstddef>
+
+namespace pstack::util {
+
+// An mdspan layout for 3D grids, which stores them as cubes of `Tile` elements on each side, one cube after another.
+// Both the cubes and the elements within each cube are in row-major order, and the grid is padded out to whole cubes.
+// Neighbours along every axis then mostly lie in the same cube, so lookups which wander through the grid in any direction,
+// rather than along z, touch far fewer cache lines and pages than with `layout_right`.
+template <std::size_t Tile>
+requires (Tile > 0 and (Tile & (Tile - 1)) == 0)
+struct layout_tiled {
+    template <class Extents>
+    requires (Extents::rank() == 3)
+    class mapping {
+    public:
+        using extents_type = Extents;
+        using index_type = typename extents_type::index_type;
+        using size_type = typename extents_type::size_type;
+        using rank_type = typename extents_type::rank_type;
+        using layout_type = layout_tiled;
+
+        constexpr mapping() noexcept = default;
+
+        constexpr mapping(const extents_type& extents) noexcept
+            : _extents(extents)
+            , _tiles{ tiles(extents.extent(0)), tiles(extents.extent(1)), tiles(extents.extent(2)) }
+        {}
+
+        constexpr const extents_type& extents() const noexcept {
+            return _extents;
+        }
+
+        constexpr index_type required_span_size() const noexcept {
+            return _tiles[0] * _tiles[1] * _tiles[2] * (Tile * Tile * Tile);
+        }
+
+        template <class I, class J, class K>
+        constexpr index_type operator()(const I i, const J j, const K k) const noexcept {
+            const index_type x = static_cast<index_type>(i);
+            const index_type y = static_cast<index_type>(j);
+            const index_type z = static_cast<index_type>(k);
+            const index_type tile = (x / Tile * _tiles[1] + y / Tile) * _tiles[2] + z / Tile;
+            return ((tile * Tile + x % Tile) * Tile + y % Tile) * Tile + z % Tile;
+        }
+
+        static constexpr bool is_always_unique() noexcept {
+            return true;
+        }
+        static constexpr bool is_always_exhaustive() noexcept {
+            return false;
+        }
+        static constexpr bool is_always_strided() noexcept {
+            return false;
+        }
+        static constexpr bool is_unique() noexcept {
+            return true;
+        }
+        constexpr bool is_exhaustive() const noexcept {
+            return _extents.extent(0) % Tile == 0 and _extents.extent(1) % Tile == 0 and _extents.extent(2) % Tile == 0;
+        }
+        static constexpr bool is_strided() noexcept {
+            return false;
+        }
+
+        friend constexpr bool operator==(const mapping& lhs, const mapping& rhs) noexcept {
+            return lhs._extents == rhs._extents;
+        }
+
+    private:
+        static constexpr index_type tiles(const index_type extent) noexcept {
+            return (extent + Tile - 1) / Tile;
+        }
+
+        extents_type _extents{};
+        std::array<index_type, 3> _tiles{};
+    };
+};
+
+} // namespace pstack::util
+
+#endif // PSTACK_UTIL_LAYOUT_TILED_HPP
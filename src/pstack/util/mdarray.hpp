@@ -13,66 +13,93 @@
 namespace pstack::util {
 
 #if defined(__cpp_lib_mdspan) and __cpp_lib_mdspan >= 202207L
-template <class T, std::size_t Rank>
-using mdspan = std::mdspan<T, std::dextents<std::size_t, Rank>>;
+template <class T, std::size_t Rank, class Layout = std::layout_right>
+using mdspan = std::mdspan<T, std::dextents<std::size_t, Rank>, Layout>;
 using std::extents;
+using std::layout_right;
 #else
-template <class T, std::size_t Rank>
-using mdspan = std::experimental::mdspan<T, std::experimental::dextents<std::size_t, Rank>>;
+template <class T, std::size_t Rank, class Layout = std::experimental::layout_right>
+using mdspan = std::experimental::mdspan<T, std::experimental::dextents<std::size_t, Rank>, Layout>;
 using std::experimental::extents;
+using std::experimental::layout_right;
 #endif
 
-template <class T, std::size_t Rank>
+// The elements are stored however `Layout` maps them, which may leave unused padding in the storage
+template <class T, std::size_t Rank, class Layout = layout_right>
 requires (not std::is_reference_v<T>)
 class mdarray {
 public:
+    using span_type = mdspan<T, Rank, Layout>;
+    using extents_type = typename span_type::extents_type;
+    using mapping_type = typename span_type::mapping_type;
+
     constexpr mdarray() = default;
 
     template <std::convertible_to<std::size_t>... Extents>
     constexpr mdarray(Extents... extents)
-        : _data((... * static_cast<std::size_t>(extents)), std::remove_const_t<T>{})
-        , _span(_data.data(), static_cast<std::size_t>(extents)...)
+        : mdarray(extents_type(static_cast<std::size_t>(extents)...))
     {}
 
     template <class IndexType, std::size_t... Extents>
     requires (sizeof...(Extents) == Rank)
     constexpr mdarray(const extents<IndexType, Extents...>& extents) {
-        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
-            _data = std::vector<std::remove_const_t<T>>((... * extents.extent(Is)), std::remove_const_t<T>{});
-            _span = mdspan<T, Rank>(_data.data(), extents);
-        }(std::make_index_sequence<Rank>{});
+        const mapping_type mapping(extents_type{ extents });
+        _data = std::vector<std::remove_const_t<T>>(mapping.required_span_size(), std::remove_const_t<T>{});
+        _span = span_type(_data.data(), mapping);
     }
 
     constexpr mdarray(const mdarray& that)
         : _data(that._data)
-        , _span(_data.data(), that._span.extents())
+        , _span(_data.data(), that._span.mapping())
     {}
 
     constexpr mdarray(mdarray&& that)
         : _data(std::move(that._data))
-        , _span(_data.data(), that._span.extents())
+        , _span(_data.data(), that._span.mapping())
     {
         that._span = {};
     }
 
     constexpr mdarray& operator=(const mdarray& that) {
         _data = that._data;
-        _span = mdspan<T, Rank>(_data.data(), that._span.extents());
+        _span = span_type(_data.data(), that._span.mapping());
         return *this;
     }
 
     constexpr mdarray& operator=(mdarray&& that) {
         _data = std::move(that._data);
-        _span = mdspan<T, Rank>(_data.data(), that._span.extents());
+        _span = span_type(_data.data(), that._span.mapping());
         that._span = {};
         return *this;
     }
 
-    constexpr operator mdspan<T, Rank>() & {
+    // Reshapes the array to `extents` and sets every element to `value`, reusing the storage it already has
+    template <class IndexType, std::size_t... Extents>
+    requires (sizeof...(Extents) == Rank)
+    constexpr void assign(const extents<IndexType, Extents...>& extents, const T& value) {
+        const mapping_type mapping(extents_type{ extents });
+        _data.assign(mapping.required_span_size(), value);
+        _span = span_type(_data.data(), mapping);
+    }
+
+    // Reshapes the array to `extents`, reusing the storage it already has, and leaving the elements with unspecified values
+    template <class IndexType, std::size_t... Extents>
+    requires (sizeof...(Extents) == Rank)
+    constexpr void resize(const extents<IndexType, Extents...>& extents) {
+        const mapping_type mapping(extents_type{ extents });
+        _data.resize(mapping.required_span_size());
+        _span = span_type(_data.data(), mapping);
+    }
+
+    constexpr operator mdspan<T, Rank, Layout>() & {
+        return _span;
+    }
+
+    constexpr operator mdspan<const T, Rank, Layout>() & {
         return _span;
     }
 
-    constexpr operator mdspan<const T, Rank>() & {
+    constexpr operator mdspan<const T, Rank, Layout>() const& {
         return _span;
     }
 
@@ -94,13 +121,13 @@ public:
 #endif
     }
 
-    constexpr std::size_t extent(std::size_t dimension) {
+    constexpr std::size_t extent(std::size_t dimension) const {
         return _span.extent(dimension);
     }
 
 private:
     std::vector<std::remove_const_t<T>> _data{};
-    mdspan<T, Rank> _span{};
+    span_type _span{};
 };
 
 } // namespace pstack::util
@@ -0,0 +1,48 @@
+#ifndef PSTACK_UTIL_PARALLEL_HPP
+#define PSTACK_UTIL_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace pstack::util {
+
+inline std::size_t thread_count() {
+    return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+
+// Calls `f(i)` for every `i` in `[0, count)`, spread over at most `thread_count()` threads.
+// The calling thread takes part in the work, and the function returns once every call has finished.
+template <class F>
+void parallel_for(const std::size_t count, F&& f) {
+    const std::size_t threads = std::min(count, thread_count());
+    if (threads <= 1) {
+        for (std::size_t i = 0; i != count; ++i) {
+            f(i);
+        }
+        return;
+    }
+
+    std::atomic<std::size_t> next{ 0 };
+    const auto work = [&] {
+        for (std::size_t i = next++; i < count; i = next++) {
+            f(i);
+        }
+    };
+
+    std::vector<std::thread> workers{};
+    workers.reserve(threads - 1);
+    for (std::size_t t = 1; t != threads; ++t) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+} // namespace pstack::util
+
+#endif // PSTACK_UTIL_PARALLEL_HPP
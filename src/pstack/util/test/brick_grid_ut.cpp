@@ -0,0 +1,73 @@
+#include "pstack/util/brick_grid.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+
+namespace pstack::util {
+namespace {
+
+TEST_CASE("elements", "[brick_grid]") {
+    // Whatever is written can be read back, whether or not the extents are whole bricks
+    std::mt19937 random(5);
+    brick_grid<int> grid(13, 9, 20);
+    std::uniform_int_distribution<int> value(0, 3);
+    for (std::size_t x = 0; x != grid.extent(0); ++x) {
+        for (std::size_t y = 0; y != grid.extent(1); ++y) {
+            for (std::size_t z = 0; z != grid.extent(2); ++z) {
+                grid.element(x, y, z) = value(random);
+            }
+        }
+    }
+    const brick_grid<int> copy = grid;
+    random.seed(5);
+    for (std::size_t x = 0; x != grid.extent(0); ++x) {
+        for (std::size_t y = 0; y != grid.extent(1); ++y) {
+            for (std::size_t z = 0; z != grid.extent(2); ++z) {
+                const int expected = value(random);
+                CHECK(grid.at(x, y, z) == expected);
+                CHECK(copy.at(x, y, z) == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("compact slabs", "[brick_grid]") {
+    // Filling one brick of each slab in full and touching one element of another leaves only the touched bricks stored
+    brick_grid<int> grid(24, 16, 16);
+    for (std::size_t bx = 0; bx != grid.bricks(0); ++bx) {
+        for (std::size_t x = bx * 8; x != bx * 8 + 8; ++x) {
+            for (std::size_t y = 0; y != 8; ++y) {
+                for (std::size_t z = 0; z != 8; ++z) {
+                    grid.element(x, y, z) = 7;
+                }
+            }
+        }
+        grid.element(bx * 8, 8, 8) = 1;
+    }
+
+    // Only the slab compacted is affected
+    grid.compact(1);
+    CHECK(grid.brick(0, 0, 0) != nullptr);
+    CHECK(grid.brick(1, 0, 0) == nullptr);
+    CHECK(grid.uniform(1, 0, 0) == 7);
+    CHECK(grid.brick(1, 1, 1) != nullptr);
+    CHECK(grid.brick(2, 0, 0) != nullptr);
+
+    grid.compact();
+    for (std::size_t bx = 0; bx != grid.bricks(0); ++bx) {
+        CHECK(grid.brick(bx, 0, 0) == nullptr);
+        CHECK(grid.uniform(bx, 0, 0) == 7);
+        CHECK(grid.brick(bx, 1, 1) != nullptr);
+        CHECK(grid.at(bx * 8, 8, 8) == 1);
+        CHECK(grid.at(bx * 8 + 1, 8, 8) == 0);
+        CHECK(grid.at(bx * 8 + 7, 7, 7) == 7);
+    }
+
+    // Writing to a compacted brick stores it again, from its uniform value
+    grid.element(3, 3, 3) = 2;
+    CHECK(grid.brick(0, 0, 0) != nullptr);
+    CHECK(grid.at(3, 3, 3) == 2);
+    CHECK(grid.at(3, 3, 4) == 7);
+}
+
+} // namespace
+} // namespace pstack::util
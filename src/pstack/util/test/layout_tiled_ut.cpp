@@ -0,0 +1,82 @@
+#include "pstack/util/layout_tiled.hpp"
+#include "pstack/util/mdarray.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <vector>
+
+namespace pstack::util {
+namespace {
+
+using extents_type = mdspan<int, 3>::extents_type;
+using tiled = layout_tiled<4>::mapping<extents_type>;
+
+TEST_CASE("unique indices", "[layout_tiled]") {
+    // Every element gets an index of its own within the span, whether or not the extents are whole tiles
+    for (const extents_type extents : { extents_type(8, 4, 12), extents_type(5, 9, 3), extents_type(1, 1, 1), extents_type(7, 1, 13) }) {
+        const tiled mapping(extents);
+        std::vector<int> uses(mapping.required_span_size());
+        for (std::size_t x = 0; x != extents.extent(0); ++x) {
+            for (std::size_t y = 0; y != extents.extent(1); ++y) {
+                for (std::size_t z = 0; z != extents.extent(2); ++z) {
+                    const std::size_t index = mapping(x, y, z);
+                    REQUIRE(index < uses.size());
+                    ++uses[index];
+                }
+            }
+        }
+        int used = 0;
+        for (const int count : uses) {
+            CHECK(count <= 1);
+            used += count;
+        }
+        CHECK(used == extents.extent(0) * extents.extent(1) * extents.extent(2));
+        CHECK(mapping.is_exhaustive() == (used == uses.size()));
+    }
+}
+
+TEST_CASE("whole tiles", "[layout_tiled]") {
+    // The first tile takes up the start of the span, in row-major order within itself
+    const tiled mapping(extents_type(8, 8, 8));
+    CHECK(mapping.required_span_size() == 512);
+    CHECK(mapping.is_exhaustive());
+    std::size_t expected = 0;
+    for (std::size_t x = 0; x != 4; ++x) {
+        for (std::size_t y = 0; y != 4; ++y) {
+            for (std::size_t z = 0; z != 4; ++z) {
+                CHECK(mapping(x, y, z) == expected++);
+            }
+        }
+    }
+    // Then the tiles follow one another, along z first
+    CHECK(mapping(0, 0, 4) == 64);
+    CHECK(mapping(0, 4, 0) == 128);
+    CHECK(mapping(4, 0, 0) == 256);
+}
+
+TEST_CASE("same elements as layout_right", "[layout_tiled]") {
+    std::mt19937 random(3);
+    std::uniform_int_distribution<int> value(-1000, 1000);
+    mdarray<int, 3> right(6, 11, 9);
+    mdarray<int, 3, layout_tiled<4>> tiled(6, 11, 9);
+    for (std::size_t x = 0; x != right.extent(0); ++x) {
+        for (std::size_t y = 0; y != right.extent(1); ++y) {
+            for (std::size_t z = 0; z != right.extent(2); ++z) {
+                right[x, y, z] = value(random);
+                tiled[x, y, z] = right[x, y, z];
+            }
+        }
+    }
+    const mdarray<int, 3, layout_tiled<4>> copy = tiled;
+    int differences = 0;
+    for (std::size_t x = 0; x != right.extent(0); ++x) {
+        for (std::size_t y = 0; y != right.extent(1); ++y) {
+            for (std::size_t z = 0; z != right.extent(2); ++z) {
+                differences += copy[x, y, z] != right[x, y, z];
+            }
+        }
+    }
+    CHECK(differences == 0);
+}
+
+} // namespace
+} // namespace pstack::util